@@ -27,6 +27,12 @@ EXAMPLE_INPUT = """
 -- Done:core=490760323
 """
 
+# workload statistics reported as test metrics: statistic name -> (metric name, unit, higher is better)
+METRICS = {
+    "workloads/sec": ("throughput", "workloads/s", True),
+    "secs/workload": ("latency", "s", False),
+}
+
 
 def harness(dut: Dut, ctx: TestContext, result: TestResult, **kwargs):
     subresult = None
@@ -41,6 +47,8 @@ def harness(dut: Dut, ctx: TestContext, result: TestResult, **kwargs):
 
     START = r"-  Info: Starting Run\.\.\.\r?\n"
     WORKLOAD = r"-- Workload:(?P<name>.*?)=(?P<size>.*?)\r?\n"
+    STATISTIC = r"-- [^:\r\n]+:(?P<key>[^=\r\n]+)=\s*(?P<value>[-+.\deE]+)\r?\n"
+    DONE = r"-- Done:.*?\r?\n"
     MESSAGE = r"(?P<line>.*?)\r?\n"
 
     while True:
@@ -85,4 +93,21 @@ def harness(dut: Dut, ctx: TestContext, result: TestResult, **kwargs):
     if subresult is None:
         result.add_subresult(subname=name, status=Status.FAIL, msg="\n".join(msg))
         return TestResult(status=Status.FAIL)
+
+    # Workload summary is printed at once after the run, read it out till the closing line
+    while True:
+        try:
+            idx = dut.expect([DONE, STATISTIC, MESSAGE], timeout=timeouts[target][name][1])
+        except (EOF, TIMEOUT) as e:
+            subresult.fail(msg=f"Error waiting for workload summary: {type(e).__name__}")
+            return TestResult(status=Status.FAIL)
+        parsed = dut.match.groupdict()
+
+        if idx == 0:
+            break
+
+        if idx == 1 and parsed["key"] in METRICS:
+            metric_name, unit, higher_is_better = METRICS[parsed["key"]]
+            subresult.add_metric(metric_name, float(parsed["value"]), unit, higher_is_better)
+
     return TestResult(status=Status.OK)
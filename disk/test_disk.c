@@ -11,18 +11,32 @@
  * %LICENSE%
  */
 
+#define _GNU_SOURCE /* O_DIRECT */
+
 #include "errno.h"
 #include "fcntl.h"
 #include "inttypes.h"
 #include "stdint.h"
 #include "stdio.h"
 #include "stdlib.h"
+#include "string.h"
 #include "unistd.h"
+#include "pthread.h"
 
 #include "sys/mman.h"
 #include "sys/time.h"
 
 
+/* Host build definitions */
+#ifndef EOK
+#define EOK 0
+#endif
+
+#ifndef _PAGE_SIZE
+#define _PAGE_SIZE 4096
+#endif
+
+
 /* Common definitions */
 #define BLOCK_SIZE         512     /* Disk block size */
 
@@ -43,6 +57,12 @@
 /* Performance test definitions */
 #define PERF_BLOCKS        0x8000  /* Blocks to read/write per single performance test */
 
+/* IOPS test definitions */
+#define IOPS_BLOCK_SIZE    4096    /* Default block size */
+#define IOPS_OPS           4096    /* Default number of operations per thread */
+#define IOPS_MAX_DEPTH     64      /* Max queue depth (number of threads) */
+#define IOPS_HIST_BUCKETS  24      /* Latency histogram buckets, bucket k holds latencies in [2^k, 2^(k+1)) usec */
+
 /* Misc definitions */
 #define BP_OFFS            0       /* Offset of 0 exponent entry in binary prefix table */
 #define BP_EXP_OFFS        10      /* Offset between consecutive entries exponents in binary prefix table */
@@ -89,6 +109,99 @@ static const char* si[] = {
 typedef struct timeval timeval_t;
 
 
+/* IOPS test configuration */
+typedef struct {
+	uint64_t blocksz;  /* Block size */
+	uint64_t nops;     /* Number of operations per thread */
+	unsigned int qd;   /* Queue depth, each thread keeps one request in flight */
+	unsigned int rpct; /* Percentage of reads */
+	int seq;           /* Sequential (per thread region) or random offsets */
+} test_disk_iopscfg_t;
+
+
+/* Output format of machine-readable records */
+enum { out_none = 0, out_kv, out_json };
+
+
+static struct {
+	int oflags;   /* Disk open flags */
+	int direct;   /* Disk is accessed with O_DIRECT, buffers have to be aligned */
+	int out;      /* Machine-readable records format */
+	uint8_t *blk; /* Page aligned single block buffer */
+	const char *image; /* Disk image created with -c, removed at exit */
+} test_disk_common;
+
+
+/* IOPS test thread */
+typedef struct {
+	pthread_t tid;
+	const char *path;
+	const test_disk_iopscfg_t *cfg;
+	uint64_t offs;    /* Thread region offset */
+	uint64_t blocks;  /* Thread region size in blocks */
+	uint32_t seed;
+	timeval_t start;
+	timeval_t end;
+	uint64_t reads;
+	uint64_t writes;
+	uint64_t rhist[IOPS_HIST_BUCKETS];
+	uint64_t whist[IOPS_HIST_BUCKETS];
+	int err;
+} test_disk_iopsthr_t;
+
+
+/* Starts machine-readable record, records are printed one per line as key=value pairs or JSON objects */
+static void test_disk_recstart(const char *test)
+{
+	if (test_disk_common.out == out_kv)
+		printf("test=%s", test);
+	else if (test_disk_common.out == out_json)
+		printf("{\"test\": \"%s\"", test);
+}
+
+
+static void test_disk_recint(const char *key, uint64_t val)
+{
+	if (test_disk_common.out == out_kv)
+		printf(" %s=%" PRIu64, key, val);
+	else if (test_disk_common.out == out_json)
+		printf(", \"%s\": %" PRIu64, key, val);
+}
+
+
+static void test_disk_recstr(const char *key, const char *val)
+{
+	if (test_disk_common.out == out_kv)
+		printf(" %s=%s", key, val);
+	else if (test_disk_common.out == out_json)
+		printf(", \"%s\": \"%s\"", key, val);
+}
+
+
+static void test_disk_recend(void)
+{
+	if (test_disk_common.out == out_kv)
+		printf("\n");
+	else if (test_disk_common.out == out_json)
+		printf("}\n");
+}
+
+
+/* Allocates page aligned buffer, as required for O_DIRECT access */
+static void *test_disk_alloc(size_t len)
+{
+	void *buff = mmap(NULL, (len + _PAGE_SIZE - 1) / _PAGE_SIZE * _PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	return (buff == MAP_FAILED) ? NULL : buff;
+}
+
+
+static void test_disk_free(void *buff, size_t len)
+{
+	munmap(buff, (len + _PAGE_SIZE - 1) / _PAGE_SIZE * _PAGE_SIZE);
+}
+
+
 static int test_disk_mod(int x, int y)
 {
 	int ret = x % y;
@@ -271,20 +384,20 @@ static int test_disk_lseek(int fd, uint64_t offs)
 static uint64_t test_disk_size(int fd)
 {
 	uint64_t offs = 0, step = 1 << 30;
-	char buff[BLOCK_SIZE];
+	uint8_t *buff = test_disk_common.blk;
 
 	/* Move forward in 1GB steps */
-	for (offs += step; !((test_disk_lseek(fd, offs) < 0) || (read(fd, buff, sizeof(buff)) != sizeof(buff))); offs += step);
+	for (offs += step; !((test_disk_lseek(fd, offs) < 0) || (read(fd, buff, BLOCK_SIZE) != BLOCK_SIZE)); offs += step);
 	offs -= step;
 	step = 1 << 25;
 
 	/* Move forward in 32MB steps */
-	for (offs += step; !((test_disk_lseek(fd, offs) < 0) || (read(fd, buff, sizeof(buff)) != sizeof(buff))); offs += step);
+	for (offs += step; !((test_disk_lseek(fd, offs) < 0) || (read(fd, buff, BLOCK_SIZE) != BLOCK_SIZE)); offs += step);
 	offs -= step;
 	step = 1 << 20;
 
 	/* Move forward in 1MB steps */
-	for (offs += step; !((test_disk_lseek(fd, offs) < 0) || (read(fd, buff, sizeof(buff)) != sizeof(buff))); offs += step);
+	for (offs += step; !((test_disk_lseek(fd, offs) < 0) || (read(fd, buff, BLOCK_SIZE) != BLOCK_SIZE)); offs += step);
 	offs -= step;
 
 	return offs;
@@ -295,7 +408,6 @@ static uint64_t test_disk_size(int fd)
 static ssize_t test_disk_seektime(int fd, uint64_t offs)
 {
 	timeval_t start, end;
-	char buff[BLOCK_SIZE];
 
 	gettimeofday(&start, NULL);
 
@@ -304,7 +416,7 @@ static ssize_t test_disk_seektime(int fd, uint64_t offs)
 		return -EINVAL;
 	}
 
-	if (read(fd, buff, sizeof(buff)) != sizeof(buff)) {
+	if (read(fd, test_disk_common.blk, BLOCK_SIZE) != BLOCK_SIZE) {
 		fprintf(stderr, "test_disk: IO error at offs=%" PRIu64 "\n", offs);
 		return -EIO;
 	}
@@ -412,31 +524,31 @@ static ssize_t test_disk_patterntime(int fd, uint64_t offs, uint64_t blocksz, ui
 	ssize_t wret, rret;
 	uint8_t *buff;
 
-	if ((buff = malloc(blocksz)) == NULL)
+	if ((buff = test_disk_alloc(blocksz)) == NULL)
 		return -ENOMEM;
 
 	if (test_disk_lseek(fd, offs) < 0) {
 		fprintf(stderr, "test_disk: bad lseek at offs=%" PRIu64 "\n", offs);
-		free(buff);
+		test_disk_free(buff, blocksz);
 		return -EINVAL;
 	}
 
 	if ((wret = test_disk_patternwtime(fd, offs, buff, blocksz, n, gen)) < 0) {
-		free(buff);
+		test_disk_free(buff, blocksz);
 		return wret;
 	}
 
 	if (test_disk_lseek(fd, offs) < 0) {
 		fprintf(stderr, "test_disk: bad lseek at offs=%" PRIu64 "\n", offs);
-		free(buff);
+		test_disk_free(buff, blocksz);
 		return -EINVAL;
 	}
 
 	if ((rret = test_disk_patternrtime(fd, offs, buff, blocksz, n, gen)) < 0) {
-		free(buff);
+		test_disk_free(buff, blocksz);
 		return rret;
 	}
-	free(buff);
+	test_disk_free(buff, blocksz);
 
 	return (uint64_t)wret + (uint64_t)rret;
 }
@@ -474,6 +586,11 @@ static int test_disk_seek(int fd, uint64_t disksz)
 	else
 		fprintf(stderr, "test_disk: no seeks measured\n");
 
+	test_disk_recstart("seek");
+	test_disk_recint("avg_us", nseeks ? time / nseeks : 0);
+	test_disk_recint("seeks", nseeks);
+	test_disk_recend();
+
 	return EOK;
 }
 
@@ -521,6 +638,11 @@ static int test_disk_zone(int fd, uint64_t disksz, uint64_t blocksz)
 	else
 		fprintf(stderr, "test_disk: no zone reads measured\n");
 
+	test_disk_recstart("zone");
+	test_disk_recint("avg_us", nzones ? time / nzones : 0);
+	test_disk_recint("zones", nzones);
+	test_disk_recend();
+
 	return EOK;
 }
 
@@ -581,31 +703,38 @@ static int test_disk_perfone(int fd, uint64_t offs, uint64_t blocksz, uint64_t n
 	uint8_t *buff;
 	char bprefix[8], srprefix[8], swprefix[8];
 
-	if ((buff = malloc(blocksz)) == NULL)
+	if ((buff = test_disk_alloc(blocksz)) == NULL)
 		return -ENOMEM;
 
 	if (test_disk_lseek(fd, offs) < 0) {
 		fprintf(stderr, "test_disk: bad lseek at offs=%" PRIu64 "\n", offs);
-		free(buff);
+		test_disk_free(buff, blocksz);
 		return -EFAULT;
 	}
 
 	if ((swtime = test_disk_patternwtime(fd, offs, buff, blocksz, n, NULL)) < 0) {
-		free(buff);
+		test_disk_free(buff, blocksz);
 		return swtime;
 	}
 
 	if (test_disk_lseek(fd, offs) < 0) {
 		fprintf(stderr, "test_disk: bad lseek at offs=%" PRIu64 "\n", offs);
-		free(buff);
+		test_disk_free(buff, blocksz);
 		return -EFAULT;
 	}
 
 	if ((srtime = test_disk_patternrtime(fd, offs, buff, blocksz, n, NULL)) < 0) {
-		free(buff);
+		test_disk_free(buff, blocksz);
 		return srtime;
 	}
-	free(buff);
+	test_disk_free(buff, blocksz);
+
+	/* Host page cache may complete all operations in less than 1 usec */
+	if (!srtime)
+		srtime = 1;
+
+	if (!swtime)
+		swtime = 1;
 
 	printf("| %5sB  | %-5" PRIu64 "  | %6sB/s  | %7sB/s  |\n",
 		test_disk_prefix(2, blocksz, 0, 0, bprefix),
@@ -613,6 +742,13 @@ static int test_disk_perfone(int fd, uint64_t offs, uint64_t blocksz, uint64_t n
 		test_disk_prefix(2, 1000000ULL * n * blocksz / (uint64_t)srtime, 0, 1, srprefix),
 		test_disk_prefix(2, 1000000ULL * n * blocksz / (uint64_t)swtime, 0, 1, swprefix));
 
+	test_disk_recstart("perf");
+	test_disk_recint("block", blocksz);
+	test_disk_recint("iops", UINT64_C(2000000) * n / ((uint64_t)srtime + (uint64_t)swtime));
+	test_disk_recint("read_bps", 1000000ULL * n * blocksz / (uint64_t)srtime);
+	test_disk_recint("write_bps", 1000000ULL * n * blocksz / (uint64_t)swtime);
+	test_disk_recend();
+
 	return EOK;
 }
 
@@ -620,25 +756,32 @@ static int test_disk_perfone(int fd, uint64_t offs, uint64_t blocksz, uint64_t n
 /* Runs pattern test */
 static int test_disk_pattern(int fd, uint64_t disksz)
 {
+	static const struct {
+		const char *name;
+		uint8_t (*gen)(uint64_t);
+	} patterns[] = {
+		{ "0x00", test_disk_pattern00 },
+		{ "0xff", test_disk_patternFF },
+		{ "0x55", test_disk_pattern55 },
+		{ "0xaa", test_disk_patternAA }
+	};
+	unsigned int i;
 	int err;
 
 	srand(time(NULL));
 
-	printf("test_disk: testing pattern 0x00...\n");
-	if ((err = test_disk_patternone(fd, disksz, test_disk_pattern00)) < 0)
-		return err;
+	for (i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+		printf("test_disk: testing pattern %s...\n", patterns[i].name);
+		err = test_disk_patternone(fd, disksz, patterns[i].gen);
 
-	printf("test_disk: testing pattern 0xff...\n");
-	if ((err = test_disk_patternone(fd, disksz, test_disk_patternFF)) < 0)
-		return err;
+		test_disk_recstart("pattern");
+		test_disk_recstr("pattern", patterns[i].name);
+		test_disk_recstr("status", (err < 0) ? "fail" : "ok");
+		test_disk_recend();
 
-	printf("test_disk: testing pattern 0x55...\n");
-	if ((err = test_disk_patternone(fd, disksz, test_disk_pattern55)) < 0)
-		return err;
-
-	printf("test_disk: testing pattern 0xaa...\n");
-	if ((err = test_disk_patternone(fd, disksz, test_disk_patternAA)) < 0)
-		return err;
+		if (err < 0)
+			return err;
+	}
 
 	printf("test_disk: pattern test finished successfully\n");
 	return EOK;
@@ -661,46 +804,463 @@ static int test_disk_perf(int fd, uint64_t disksz)
 }
 
 
-int main(int argc, char *argv[])
+/* xorshift32, rand() state is shared between the threads */
+static uint32_t test_disk_rand(uint32_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+
+	return *seed;
+}
+
+
+static void test_disk_histadd(uint64_t *hist, uint64_t t)
+{
+	unsigned int k = (t > 0) ? test_disk_log(2, (t > UINT32_MAX) ? UINT32_MAX : (unsigned int)t) : 0;
+
+	if (k >= IOPS_HIST_BUCKETS)
+		k = IOPS_HIST_BUCKETS - 1;
+
+	hist[k]++;
+}
+
+
+/* Returns upper bound of the latency bucket holding pct percent of the operations */
+static uint64_t test_disk_histpct(const uint64_t *hist, uint64_t n, unsigned int pct)
+{
+	uint64_t cnt = 0;
+	unsigned int k;
+
+	for (k = 0; k < IOPS_HIST_BUCKETS; k++) {
+		if ((cnt += hist[k]) * 100 >= n * pct)
+			break;
+	}
+
+	return (uint64_t)1 << (k + 1);
+}
+
+
+/* Performs IOPS test operations of a single thread */
+static void *test_disk_iopsthr(void *arg)
+{
+	test_disk_iopsthr_t *thr = (test_disk_iopsthr_t *)arg;
+	const test_disk_iopscfg_t *cfg = thr->cfg;
+	timeval_t start, end;
+	uint64_t i, t, offs;
+	uint8_t *buff;
+	ssize_t ret;
+	int fd, rd;
+
+	if ((buff = test_disk_alloc(cfg->blocksz)) == NULL) {
+		thr->err = -ENOMEM;
+		return NULL;
+	}
+	memset(buff, 0x5a, cfg->blocksz);
+
+	/* Each thread has its own file descriptor, so its seek + read/write is atomic */
+	if ((fd = open(thr->path, ((cfg->rpct < 100) ? O_RDWR : O_RDONLY) | test_disk_common.oflags)) < 0) {
+		fprintf(stderr, "test_disk: failed to open disk %s\n", thr->path);
+		test_disk_free(buff, cfg->blocksz);
+		thr->err = -EINVAL;
+		return NULL;
+	}
+
+	gettimeofday(&thr->start, NULL);
+
+	for (i = 0; i < cfg->nops; i++) {
+		offs = cfg->seq ? i % thr->blocks : test_disk_rand(&thr->seed) % thr->blocks;
+		offs = thr->offs + offs * cfg->blocksz;
+		rd = (test_disk_rand(&thr->seed) % 100) < cfg->rpct;
+
+		gettimeofday(&start, NULL);
+
+		if (test_disk_lseek(fd, offs) < 0) {
+			fprintf(stderr, "test_disk: bad lseek at offs=%" PRIu64 "\n", offs);
+			thr->err = -EINVAL;
+			break;
+		}
+
+		ret = rd ? read(fd, buff, cfg->blocksz) : write(fd, buff, cfg->blocksz);
+		if (ret != cfg->blocksz) {
+			fprintf(stderr, "test_disk: IO error at offs=%" PRIu64 "\n", offs);
+			thr->err = -EIO;
+			break;
+		}
+
+		gettimeofday(&end, NULL);
+		t = test_disk_time(&start, &end);
+
+		if (rd) {
+			test_disk_histadd(thr->rhist, t);
+			thr->reads++;
+		}
+		else {
+			test_disk_histadd(thr->whist, t);
+			thr->writes++;
+		}
+	}
+
+	gettimeofday(&thr->end, NULL);
+	close(fd);
+	test_disk_free(buff, cfg->blocksz);
+
+	return NULL;
+}
+
+
+/* Prints latency histogram and percentiles of one operation type */
+static void test_disk_iopshist(const char *op, const uint64_t *hist, uint64_t n)
+{
+	unsigned int k;
+
+	if (!n)
+		return;
+
+	printf("test_disk: %s latency p50 < %" PRIu64 "us, p99 < %" PRIu64 "us, max < %" PRIu64 "us\n", op,
+		test_disk_histpct(hist, n, 50), test_disk_histpct(hist, n, 99), test_disk_histpct(hist, n, 100));
+
+	for (k = 0; k < IOPS_HIST_BUCKETS; k++) {
+		if (hist[k]) {
+			printf("test_disk: %s [%8" PRIu64 ", %8" PRIu64 ") us: %-8" PRIu64 " %5.1f%%\n", op,
+				(k) ? (uint64_t)1 << k : 0, (uint64_t)1 << (k + 1), hist[k], 100.0 * hist[k] / n);
+
+			test_disk_recstart("iops_hist");
+			test_disk_recstr("op", op);
+			test_disk_recint("lo_us", (k) ? (uint64_t)1 << k : 0);
+			test_disk_recint("hi_us", (uint64_t)1 << (k + 1));
+			test_disk_recint("count", hist[k]);
+			test_disk_recend();
+		}
+	}
+}
+
+
+/* Runs IOPS test - qd threads performing random or sequential reads/writes mix */
+static int test_disk_iops(const char *path, uint64_t disksz, const test_disk_iopscfg_t *cfg)
+{
+	uint64_t rhist[IOPS_HIST_BUCKETS] = { 0 }, whist[IOPS_HIST_BUCKETS] = { 0 };
+	uint64_t blocks = disksz / cfg->blocksz / cfg->qd, reads = 0, writes = 0, time;
+	timeval_t start, end;
+	test_disk_iopsthr_t *thrs;
+	unsigned int i, k;
+	char bprefix[8], rprefix[8], wprefix[8];
+	int err = EOK;
+
+	if (!blocks) {
+		fprintf(stderr, "test_disk: disk too small for %u threads with %" PRIu64 "B blocks\n", cfg->qd, cfg->blocksz);
+		return -EINVAL;
+	}
+
+	if ((thrs = calloc(cfg->qd, sizeof(*thrs))) == NULL)
+		return -ENOMEM;
+
+	printf("test_disk: %s %u%% reads, block %sB, queue depth %u, %" PRIu64 " ops per thread\n",
+		cfg->seq ? "sequential" : "random", cfg->rpct, test_disk_prefix(2, cfg->blocksz, 0, 0, bprefix), cfg->qd, cfg->nops);
+
+	for (i = 0; i < cfg->qd; i++) {
+		thrs[i].path = path;
+		thrs[i].cfg = cfg;
+		/* Random offsets span the whole disk, sequential ones the thread region */
+		thrs[i].offs = cfg->seq ? i * blocks * cfg->blocksz : 0;
+		thrs[i].blocks = cfg->seq ? blocks : blocks * cfg->qd;
+		thrs[i].seed = 2463534242U + i;
+
+		if (pthread_create(&thrs[i].tid, NULL, test_disk_iopsthr, &thrs[i]) != 0) {
+			fprintf(stderr, "test_disk: failed to create thread\n");
+			err = -ENOMEM;
+			break;
+		}
+	}
+
+	while (i-- > 0)
+		pthread_join(thrs[i].tid, NULL);
+
+	if (err < 0) {
+		free(thrs);
+		return err;
+	}
+
+	start = thrs[0].start;
+	end = thrs[0].end;
+	for (i = 0; i < cfg->qd; i++) {
+		if (thrs[i].err < 0)
+			err = thrs[i].err;
+
+		if (test_disk_time(&thrs[i].start, &start))
+			start = thrs[i].start;
+
+		if (test_disk_time(&end, &thrs[i].end))
+			end = thrs[i].end;
+
+		reads += thrs[i].reads;
+		writes += thrs[i].writes;
+		for (k = 0; k < IOPS_HIST_BUCKETS; k++) {
+			rhist[k] += thrs[i].rhist[k];
+			whist[k] += thrs[i].whist[k];
+		}
+	}
+	free(thrs);
+
+	if (err < 0)
+		return err;
+
+	if (!(time = test_disk_time(&start, &end)))
+		time = 1;
+
+	printf("test_disk: %" PRIu64 " IOPS, read %sB/s, write %sB/s\n", UINT64_C(1000000) * (reads + writes) / time,
+		test_disk_prefix(2, 1000000ULL * reads * cfg->blocksz / time, 0, 1, rprefix),
+		test_disk_prefix(2, 1000000ULL * writes * cfg->blocksz / time, 0, 1, wprefix));
+
+	test_disk_recstart("iops");
+	test_disk_recstr("mode", cfg->seq ? "seq" : "rand");
+	test_disk_recint("read_pct", cfg->rpct);
+	test_disk_recint("block", cfg->blocksz);
+	test_disk_recint("qd", cfg->qd);
+	test_disk_recint("ops", reads + writes);
+	test_disk_recint("iops", UINT64_C(1000000) * (reads + writes) / time);
+	test_disk_recint("read_bps", 1000000ULL * reads * cfg->blocksz / time);
+	test_disk_recint("write_bps", 1000000ULL * writes * cfg->blocksz / time);
+	if (reads) {
+		test_disk_recint("read_p50_us", test_disk_histpct(rhist, reads, 50));
+		test_disk_recint("read_p99_us", test_disk_histpct(rhist, reads, 99));
+		test_disk_recint("read_max_us", test_disk_histpct(rhist, reads, 100));
+	}
+	if (writes) {
+		test_disk_recint("write_p50_us", test_disk_histpct(whist, writes, 50));
+		test_disk_recint("write_p99_us", test_disk_histpct(whist, writes, 99));
+		test_disk_recint("write_max_us", test_disk_histpct(whist, writes, 100));
+	}
+	test_disk_recend();
+
+	test_disk_iopshist("read", rhist, reads);
+	test_disk_iopshist("write", whist, writes);
+
+	return EOK;
+}
+
+
+/* Creates regular file disk image on host, it's filled with data, so reads don't hit file holes */
+static void test_disk_removeImage(void)
+{
+	if (test_disk_common.image != NULL)
+		unlink(test_disk_common.image);
+}
+
+
+static int test_disk_create(const char *path, uint64_t size)
+{
+	uint64_t offs;
+	uint8_t *buff;
+	int fd, err = EOK;
+
+	if ((buff = test_disk_alloc(1 << 20)) == NULL)
+		return -ENOMEM;
+	memset(buff, 0xa5, 1 << 20);
+
+	if ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+		fprintf(stderr, "test_disk: failed to create disk image %s\n", path);
+		test_disk_free(buff, 1 << 20);
+		return -EIO;
+	}
+
+	for (offs = 0; offs < size; offs += 1 << 20) {
+		if (write(fd, buff, 1 << 20) != 1 << 20) {
+			fprintf(stderr, "test_disk: IO error at offs=%" PRIu64 "\n", offs);
+			err = -EIO;
+			break;
+		}
+	}
+
+	if ((err == EOK) && (fsync(fd) < 0))
+		err = -EIO;
+
+	close(fd);
+	test_disk_free(buff, 1 << 20);
+
+	return err;
+}
+
+
+/* Opens disk, O_DIRECT is used if available, so host page cache doesn't hide the storage performance */
+static int test_disk_open(const char *path, int direct)
 {
-	uint64_t size;
 	int fd;
 
-	if (argc != 2) {
-		printf("Usage: %s <disk device>\n", argv[0]);
+#ifdef O_DIRECT
+	if (direct) {
+		if ((fd = open(path, O_RDWR | O_DIRECT)) >= 0) {
+			/* Unsupported O_DIRECT or block size below the device logical block size fails with EINVAL */
+			if ((lseek(fd, BLOCK_SIZE, SEEK_SET) == BLOCK_SIZE) && (read(fd, test_disk_common.blk, BLOCK_SIZE) == BLOCK_SIZE)) {
+				test_disk_common.oflags = O_DIRECT;
+				test_disk_common.direct = 1;
+				return fd;
+			}
+			close(fd);
+		}
+		printf("test_disk: O_DIRECT not supported for %s, using buffered IO\n", path);
+	}
+#endif
+
+	if ((fd = open(path, O_RDWR)) < 0)
+		return -EINVAL;
+
+	return fd;
+}
+
+
+static void test_disk_usage(const char *progname)
+{
+	printf("Usage: %s [options] <disk device or file>\n", progname);
+	printf("  -i        run IOPS test only (destructive if writes are enabled)\n");
+	printf("  -b SIZE   IOPS test block size (default: %u)\n", IOPS_BLOCK_SIZE);
+	printf("  -q DEPTH  IOPS test queue depth - number of concurrent threads (default: 1, max: %u)\n", IOPS_MAX_DEPTH);
+	printf("  -r PCT    IOPS test percentage of reads (default: 100)\n");
+	printf("  -s        IOPS test sequential offsets (default: random)\n");
+	printf("  -n OPS    IOPS test operations per thread (default: %u)\n", IOPS_OPS);
+	printf("  -c SIZE   create SIZE MB disk image file on host before the tests, removed at exit\n");
+	printf("  -u        use buffered IO (default: O_DIRECT if supported)\n");
+	printf("  -o FMT    print machine-readable results, one record per line (FMT: kv, json)\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+	test_disk_iopscfg_t cfg = { .blocksz = IOPS_BLOCK_SIZE, .nops = IOPS_OPS, .qd = 1, .rpct = 100, .seq = 0 };
+	const char *path;
+	uint64_t size, create = 0;
+	int c, fd, iops = 0, direct = 1, err = EOK;
+
+	while ((c = getopt(argc, argv, "ib:q:r:sn:c:uo:h")) != -1) {
+		switch (c) {
+		case 'i':
+			iops = 1;
+			break;
+
+		case 'b':
+			cfg.blocksz = strtoull(optarg, NULL, 0);
+			break;
+
+		case 'q':
+			cfg.qd = strtoul(optarg, NULL, 0);
+			break;
+
+		case 'r':
+			cfg.rpct = strtoul(optarg, NULL, 0);
+			break;
+
+		case 's':
+			cfg.seq = 1;
+			break;
+
+		case 'n':
+			cfg.nops = strtoull(optarg, NULL, 0);
+			break;
+
+		case 'c':
+			create = strtoull(optarg, NULL, 0);
+			break;
+
+		case 'u':
+			direct = 0;
+			break;
+
+		case 'o':
+			if (!strcmp(optarg, "kv"))
+				test_disk_common.out = out_kv;
+			else if (!strcmp(optarg, "json"))
+				test_disk_common.out = out_json;
+			else {
+				test_disk_usage(argv[0]);
+				return EOK;
+			}
+			break;
+
+		default:
+			test_disk_usage(argv[0]);
+			return EOK;
+		}
+	}
+
+	if ((optind != argc - 1) || !cfg.blocksz || !cfg.nops || !cfg.qd || (cfg.qd > IOPS_MAX_DEPTH) || (cfg.rpct > 100)) {
+		test_disk_usage(argv[0]);
 		return EOK;
 	}
+	path = argv[optind];
 
 	printf("test_disk: starting, main is at %p\n", main);
 
-	if ((fd = open(argv[1], 0)) < 0) {
-		fprintf(stderr, "test_disk: failed to open disk %s\n", argv[1]);
+	if ((test_disk_common.blk = test_disk_alloc(BLOCK_SIZE)) == NULL) {
+		fprintf(stderr, "test_disk: failed to allocate memory\n");
+		return -ENOMEM;
+	}
+
+	if (create) {
+		test_disk_common.image = path;
+		atexit(test_disk_removeImage);
+
+		if ((err = test_disk_create(path, create << 20)) < 0)
+			return err;
+	}
+
+	if ((fd = test_disk_open(path, direct)) < 0) {
+		fprintf(stderr, "test_disk: failed to open disk %s\n", path);
+		return -EINVAL;
+	}
+
+	if (test_disk_common.direct && (cfg.blocksz % BLOCK_SIZE)) {
+		fprintf(stderr, "test_disk: IOPS test block size has to be a multiple of %u for O_DIRECT\n", BLOCK_SIZE);
+		close(fd);
 		return -EINVAL;
 	}
 
 	if (!(size = test_disk_size(fd))) {
-		fprintf(stderr, "test_disk: disk %s has less than 1MB of storage capacity required for the tests to run. Exiting...\n", argv[1]);
+		fprintf(stderr, "test_disk: disk %s has less than 1MB of storage capacity required for the tests to run. Exiting...\n", path);
+		close(fd);
 		return EOK;
 	}
-	printf("test_disk: disk %s has %" PRIu64 "MB of storage capacity\n", argv[1], size / (1 << 20));
+	printf("test_disk: disk %s has %" PRIu64 "MB of storage capacity%s\n", path, size / (1 << 20), test_disk_common.direct ? ", using O_DIRECT" : "");
 
-	printf("********************************\n");
-	printf("test_disk: starting seek test...\n");
-	test_disk_seek(fd, size);
+	test_disk_recstart("disk");
+	test_disk_recint("size", size);
+	test_disk_recint("direct", test_disk_common.direct);
+	test_disk_recend();
 
-	printf("********************************\n");
-	printf("test_disk: starting zone test...\n");
-	test_disk_zone(fd, size, 1 << 20);
-
-	/* Warning: destructive test, overwrites disk data */
-	printf("***********************************\n");
-	printf("test_disk: starting pattern test...\n");
-	test_disk_pattern(fd, size);
+	if (iops) {
+		printf("*******************************\n");
+		printf("test_disk: starting IOPS test...\n");
+		err = test_disk_iops(path, size, &cfg);
+	}
+	else {
+		printf("********************************\n");
+		printf("test_disk: starting seek test...\n");
+		if ((c = test_disk_seek(fd, size)) < 0)
+			err = c;
+
+		printf("********************************\n");
+		printf("test_disk: starting zone test...\n");
+		if ((c = test_disk_zone(fd, size, 1 << 20)) < 0)
+			err = c;
+
+		/* Warning: destructive test, overwrites disk data */
+		printf("***********************************\n");
+		printf("test_disk: starting pattern test...\n");
+		if ((c = test_disk_pattern(fd, size)) < 0)
+			err = c;
+
+		/* Warning: destructive test, overwrites disk data */
+		printf("***************************************\n");
+		printf("test_disk: starting performance test...\n");
+		if ((c = test_disk_perf(fd, size)) < 0)
+			err = c;
+	}
+	close(fd);
 
-	/* Warning: destructive test, overwrites disk data */
-	printf("***************************************\n");
-	printf("test_disk: starting performance test...\n");
-	test_disk_perf(fd, size);
+	/* Marks the end of results for the test runner */
+	test_disk_recstart("done");
+	test_disk_recstr("status", (err < 0) ? "fail" : "ok");
+	test_disk_recend();
+	printf("test_disk: finished%s\n", (err < 0) ? " with errors" : "");
 
 	return EOK;
 }
@@ -0,0 +1,97 @@
+#
+# Phoenix-RTOS test runner
+#
+# The harness for the disk benchmark, parses its machine-readable records (-o kv)
+#
+# Copyright 2025 Phoenix Systems
+#
+
+from pexpect.exceptions import EOF, TIMEOUT
+from trunner.ctx import TestContext
+from trunner.dut import Dut
+from trunner.types import Status, TestResult
+
+EXAMPLE_INPUT = """
+test=disk size=66060288 direct=1
+test=seek avg_us=1208 seeks=24
+test=perf block=4096 iops=40364 read_bps=212506113 write_bps=135300129
+test=iops mode=rand read_pct=70 block=4096 qd=4 ops=16384 iops=53460 read_p99_us=2048
+test=done status=ok
+"""
+
+TIMEOUT_S = 600
+
+# record fields reported as test metrics: field name -> (unit, higher is better)
+METRICS = {
+    "avg_us": ("us", False),
+    "iops": ("IOPS", True),
+    "read_bps": ("B/s", True),
+    "write_bps": ("B/s", True),
+    "read_p50_us": ("us", False),
+    "read_p99_us": ("us", False),
+    "read_max_us": ("us", False),
+    "write_p50_us": ("us", False),
+    "write_p99_us": ("us", False),
+    "write_max_us": ("us", False),
+}
+
+
+def record_subname(test, fields):
+    if test == "perf":
+        return f"perf.block{fields['block']}"
+
+    if test == "iops":
+        return f"iops.{fields['mode']}.read{fields['read_pct']}.block{fields['block']}.qd{fields['qd']}"
+
+    if test == "pattern":
+        return f"pattern.{fields['pattern']}"
+
+    return test
+
+
+def harness(dut: Dut, ctx: TestContext, result: TestResult, **kwargs):
+    msg = []
+    any_failed = False
+
+    RECORD = r"test=(?P<test>\w+)(?P<fields>( [\w.]+=\S*)*)\r?\n"
+    MESSAGE = r"(?P<line>.*?)\r?\n"
+
+    while True:
+        try:
+            idx = dut.expect([RECORD, MESSAGE], timeout=TIMEOUT_S)
+        except (EOF, TIMEOUT) as e:
+            msg.append(f"Error waiting for output: {type(e).__name__}")
+            result.add_subresult(subname="done", status=Status.FAIL, msg="\n".join(msg))
+            return TestResult(status=Status.FAIL)
+        parsed = dut.match.groupdict()
+
+        if idx == 1:
+            msg.append(parsed["line"])
+            continue
+
+        test = parsed["test"]
+        fields = dict(f.split("=", 1) for f in parsed["fields"].split())
+
+        # iops histogram buckets and disk parameters are kept in the raw output only
+        if test in ("disk", "iops_hist"):
+            continue
+
+        failed = fields.get("status", "ok") != "ok"
+        any_failed = any_failed or failed
+        subresult = result.add_subresult(
+            subname=record_subname(test, fields),
+            status=Status.FAIL if failed else Status.OK,
+            msg="\n".join(msg) if failed else "",
+        )
+        msg = []
+
+        if test == "done":
+            break
+
+        for key, value in fields.items():
+            if key in METRICS:
+                unit, higher_is_better = METRICS[key]
+                subresult.add_metric(key, float(value), unit, higher_is_better)
+
+    # overall status overwrites the one derived from subresults, failed record (e.g. pattern mismatch) fails the test
+    return TestResult(status=Status.FAIL if any_failed else Status.OK)
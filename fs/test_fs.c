@@ -2,6 +2,7 @@
  * Phoenix-RTOS
  *
  * Filesystem benchmark - based on lmbench (https://github.com/intel/lmbench/blob/master/src/lat_fs.c)
+ * Metadata benchmark (-m) - in the style of fs_mark/mdtest
  *
  * Copyright 2020 Phoenix Systems
  * Author: Lukasz Kosinski
@@ -18,18 +19,32 @@
 #include "stdio.h"
 #include "stdlib.h"
 #include "string.h"
+#include "time.h"
 #include "unistd.h"
+#include "dirent.h"
+#include "pthread.h"
 
 #include "sys/stat.h"
 #include "sys/time.h"
 
 
+/* Host build definitions */
+#ifndef EOK
+#define EOK 0
+#endif
+
+
 /* Misc definitions */
 #define DIR_NAME      "test_fs_XXXXXX" /* Test directory name template */
 #define DIR_NAME_FMT  "%s/" DIR_NAME   /* Test directory path format */
 #define DIR_MAX_FILES 100              /* Max number of files per directory */
 #define NFILES        1000             /* Number of files to create/remove per test */
 
+/* Metadata benchmark definitions */
+#define MD_THREADS     4                /* Default max number of threads */
+#define MD_MAX_THREADS 64               /* Max number of threads */
+#define MD_MAX_FILES   100000           /* Max number of files per directory in the sweep */
+
 
 typedef struct timeval timeval_t;
 
@@ -38,6 +53,13 @@ typedef struct timeval timeval_t;
 static const unsigned int fsizes[] = { 0x0, 0x400, 0x1000, 0x2800 };
 
 
+/* Metadata operations */
+enum { md_create = 0, md_stat, md_open, md_readdir, md_rename, md_unlink, md_ops };
+
+
+static const char *const mdops[] = { "create", "stat", "open/close", "readdir", "rename", "unlink" };
+
+
 typedef struct {
 	char *tmp;           /* Root directory */
 	char **dirs;         /* Directory names */
@@ -48,6 +70,23 @@ typedef struct {
 } test_fs_state_t;
 
 
+/* Metadata benchmark thread */
+typedef struct {
+	pthread_t tid;
+	test_fs_state_t *state;
+	unsigned int idx;      /* Thread index */
+	unsigned int nthreads; /* Number of threads */
+	int op;                /* Metadata operation */
+	char *buff;            /* Renamed file name buffer */
+	uint32_t *lat;         /* Operations latencies in nsec */
+	uint64_t cap;          /* Latencies buffer capacity */
+	uint64_t n;            /* Number of performed operations */
+	uint64_t start;        /* Operations start time in nsec */
+	uint64_t end;          /* Operations end time in nsec */
+	int err;
+} test_fs_mdthr_t;
+
+
 /* Calculates time delta in usec */
 static uint64_t test_fs_gettime(timeval_t *start, timeval_t *end)
 {
@@ -70,6 +109,17 @@ static uint64_t test_fs_gettime(timeval_t *start, timeval_t *end)
 }
 
 
+/* Returns monotonic time in nsec */
+static uint64_t test_fs_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
 /* Counts digits */
 static unsigned int test_fs_digits(unsigned int n, unsigned int base)
 {
@@ -265,19 +315,330 @@ static int test_fs_run(test_fs_state_t *state)
 }
 
 
+/* Stores latency of one metadata operation */
+static void test_fs_mdlat(test_fs_mdthr_t *thr, uint64_t start)
+{
+	uint64_t t = test_fs_nsec() - start;
+
+	if (thr->n < thr->cap)
+		thr->lat[thr->n] = (t > UINT32_MAX) ? UINT32_MAX : (uint32_t)t;
+	thr->n++;
+}
+
+
+/* Reads whole directory, every readdir() call is one operation */
+static int test_fs_mdreaddir(test_fs_mdthr_t *thr, const char *path)
+{
+	struct dirent *d;
+	uint64_t start;
+	DIR *dir;
+
+	if ((dir = opendir(path)) == NULL) {
+		fprintf(stderr, "test_fs: failed to open directory %s\n", path);
+		return -ENOENT;
+	}
+
+	for (;;) {
+		start = test_fs_nsec();
+		if ((d = readdir(dir)) == NULL)
+			break;
+		test_fs_mdlat(thr, start);
+	}
+	closedir(dir);
+
+	return EOK;
+}
+
+
+/* Performs metadata operations of a single thread, files and directories are interleaved between the threads */
+static void *test_fs_mdthr(void *arg)
+{
+	test_fs_mdthr_t *thr = (test_fs_mdthr_t *)arg;
+	test_fs_state_t *state = thr->state;
+	struct stat st;
+	uint64_t start;
+	unsigned int i;
+	char *name;
+	int fd;
+
+	thr->n = 0;
+	thr->err = EOK;
+	thr->start = test_fs_nsec();
+
+	if (thr->op == md_readdir) {
+		for (i = thr->idx; i < state->ndirs; i += thr->nthreads) {
+			if ((thr->err = test_fs_mdreaddir(thr, state->dirs[i])) < 0)
+				break;
+		}
+		thr->end = test_fs_nsec();
+
+		return NULL;
+	}
+
+	for (i = thr->idx; i < state->nfiles; i += thr->nthreads) {
+		name = state->names[i];
+
+		/* Files are renamed to <name>r, remove the renamed files */
+		if (thr->op == md_unlink) {
+			sprintf(thr->buff, "%sr", name);
+			name = thr->buff;
+		}
+
+		start = test_fs_nsec();
+
+		switch (thr->op) {
+		case md_create:
+			if ((fd = open(name, O_WRONLY | O_CREAT | O_EXCL, DEFFILEMODE)) < 0)
+				thr->err = -errno;
+			else
+				close(fd);
+			break;
+
+		case md_stat:
+			if (stat(name, &st) < 0)
+				thr->err = -errno;
+			break;
+
+		case md_open:
+			if ((fd = open(name, O_RDONLY)) < 0)
+				thr->err = -errno;
+			else
+				close(fd);
+			break;
+
+		case md_rename:
+			sprintf(thr->buff, "%sr", name);
+			if (rename(name, thr->buff) < 0)
+				thr->err = -errno;
+			break;
+
+		case md_unlink:
+			if (unlink(name) < 0)
+				thr->err = -errno;
+			break;
+		}
+
+		if (thr->err < 0) {
+			fprintf(stderr, "test_fs: %s failed on file %s\n", mdops[thr->op], name);
+			break;
+		}
+
+		test_fs_mdlat(thr, start);
+	}
+	thr->end = test_fs_nsec();
+
+	return NULL;
+}
+
+
+static int test_fs_mdcmp(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+
+/* Runs one metadata operation in nthreads threads and reports its rate and latency */
+static int test_fs_mdop(test_fs_state_t *state, test_fs_mdthr_t *thrs, unsigned int nthreads, int op, uint32_t *lat)
+{
+	uint64_t start, end, ops = 0, n = 0;
+	unsigned int i;
+	int err = EOK;
+
+	for (i = 0; i < nthreads; i++) {
+		thrs[i].op = op;
+		if (pthread_create(&thrs[i].tid, NULL, test_fs_mdthr, &thrs[i]) != 0) {
+			fprintf(stderr, "test_fs: failed to create thread\n");
+			err = -ENOMEM;
+			break;
+		}
+	}
+
+	while (i-- > 0)
+		pthread_join(thrs[i].tid, NULL);
+
+	if (err < 0)
+		return err;
+
+	start = thrs[0].start;
+	end = thrs[0].end;
+	for (i = 0; i < nthreads; i++) {
+		if (thrs[i].err < 0)
+			err = thrs[i].err;
+
+		if (thrs[i].start < start)
+			start = thrs[i].start;
+
+		if (thrs[i].end > end)
+			end = thrs[i].end;
+
+		/* Merge latencies of all threads */
+		ops += thrs[i].n;
+		memcpy(lat + n, thrs[i].lat, ((thrs[i].n < thrs[i].cap) ? thrs[i].n : thrs[i].cap) * sizeof(*lat));
+		n += (thrs[i].n < thrs[i].cap) ? thrs[i].n : thrs[i].cap;
+	}
+
+	if (err < 0)
+		return err;
+
+	if (end == start)
+		end++;
+
+	qsort(lat, n, sizeof(*lat), test_fs_mdcmp);
+
+	printf("| %9u | %7u | %-10s | %9" PRIu64 " | %10" PRIu32 " | %10" PRIu32 " |\n", state->fmax, nthreads, mdops[op],
+		UINT64_C(1000000000) * ops / (end - start), n ? lat[n / 2] : 0, n ? lat[n * 99 / 100] : 0);
+
+	return EOK;
+}
+
+
+/* Runs metadata benchmark for fmax files per directory and nthreads threads */
+static int test_fs_mdrun(test_fs_state_t *state, unsigned int nthreads)
+{
+	test_fs_mdthr_t *thrs;
+	unsigned int i, len = 0;
+	uint32_t *lat = NULL;
+	uint64_t cap;
+	int op, err;
+
+	if ((err = test_fs_setup(state)) < 0) {
+		fprintf(stderr, "test_fs: failed on test setup\n");
+		return err;
+	}
+
+	for (i = 0; i < state->nfiles; i++) {
+		if (strlen(state->names[i]) > len)
+			len = strlen(state->names[i]);
+	}
+
+	/* Per thread share of the files or readdir entries, whichever is greater */
+	cap = (state->ndirs / nthreads + 1) * (uint64_t)(state->fmax + 2);
+	if (cap < state->nfiles / nthreads + 1)
+		cap = state->nfiles / nthreads + 1;
+
+	if ((thrs = calloc(nthreads, sizeof(*thrs))) == NULL) {
+		test_fs_cleanup(state);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < nthreads; i++) {
+		thrs[i].state = state;
+		thrs[i].idx = i;
+		thrs[i].nthreads = nthreads;
+		thrs[i].cap = cap;
+		if (((thrs[i].buff = malloc(len + 2)) == NULL) || ((thrs[i].lat = malloc(cap * sizeof(uint32_t))) == NULL)) {
+			err = -ENOMEM;
+			break;
+		}
+	}
+
+	if ((err == EOK) && ((lat = malloc(nthreads * cap * sizeof(uint32_t))) == NULL))
+		err = -ENOMEM;
+
+	for (op = md_create; (err == EOK) && (op < md_ops); op++)
+		err = test_fs_mdop(state, thrs, nthreads, op, lat);
+
+	/* Remove renamed files left after a failure */
+	if ((err < 0) && (op > md_rename)) {
+		for (i = 0; i < state->nfiles; i++) {
+			sprintf(thrs[0].buff, "%sr", state->names[i]);
+			unlink(thrs[0].buff);
+		}
+	}
+
+	for (i = 0; i < nthreads; i++) {
+		free(thrs[i].buff);
+		free(thrs[i].lat);
+	}
+	free(thrs);
+	free(lat);
+	test_fs_cleanup(state);
+
+	if (err == -ENOMEM)
+		fprintf(stderr, "test_fs: failed to allocate memory\n");
+
+	return err;
+}
+
+
+/* Runs metadata benchmark - files per directory ratio from 10 to MD_MAX_FILES, 1 to nthreads threads */
+static int test_fs_md(test_fs_state_t *state, unsigned int fmax, unsigned int nthreads)
+{
+	unsigned int f, t;
+	int err;
+
+	printf("test_fs: metadata benchmark, %u files, rates in ops/s, latencies in ns\n", state->nfiles);
+	printf("| FILES/DIR | THREADS |     OP     |   OPS/S   |    P50     |    P99     |\n");
+
+	for (f = (fmax) ? fmax : 10; f <= ((fmax) ? fmax : MD_MAX_FILES); f *= 10) {
+		/* Directory can't hold more files than all of the files */
+		if ((f > state->nfiles) && (f != fmax))
+			break;
+
+		for (t = 1; t <= nthreads; t = (t < nthreads) && (2 * t > nthreads) ? nthreads : 2 * t) {
+			state->fmax = f;
+			if ((err = test_fs_mdrun(state, t)) < 0)
+				return err;
+		}
+	}
+
+	return EOK;
+}
+
+
+static void test_fs_usage(const char *progname)
+{
+	printf("Usage: %s [options] <tmp dir>\n", progname);
+	printf("  -m        run metadata benchmark (create, stat, open/close, readdir, rename, unlink)\n");
+	printf("  -n FILES  number of files (default: %u)\n", NFILES);
+	printf("  -d FILES  metadata benchmark files per directory (default: 10 to %u sweep)\n", MD_MAX_FILES);
+	printf("  -t NUM    metadata benchmark max number of threads (default: %u, max: %u)\n", MD_THREADS, MD_MAX_THREADS);
+}
+
+
 int main(int argc, char *argv[])
 {
 	test_fs_state_t state = { .nfiles = NFILES, .fmax = DIR_MAX_FILES };
-	int err;
+	unsigned int fmax = 0, nthreads = MD_THREADS;
+	int c, err, md = 0;
+
+	while ((c = getopt(argc, argv, "mn:d:t:h")) != -1) {
+		switch (c) {
+		case 'm':
+			md = 1;
+			break;
+
+		case 'n':
+			state.nfiles = strtoul(optarg, NULL, 0);
+			break;
+
+		case 'd':
+			fmax = strtoul(optarg, NULL, 0);
+			break;
+
+		case 't':
+			nthreads = strtoul(optarg, NULL, 0);
+			break;
+
+		default:
+			test_fs_usage(argv[0]);
+			return EOK;
+		}
+	}
 
-	if (argc != 2) {
-		printf("Usage: %s <tmp dir>\n", argv[0]);
+	if ((optind != argc - 1) || !state.nfiles || (fmax == 1) || !nthreads || (nthreads > MD_MAX_THREADS)) {
+		test_fs_usage(argv[0]);
 		return EOK;
 	}
-	state.tmp = argv[1];
+	state.tmp = argv[optind];
 
 	printf("test_fs: starting, main is at %p\n", main);
 
+	if (md)
+		return test_fs_md(&state, fmax, nthreads);
+
 	if ((err = test_fs_setup(&state)) < 0) {
 		fprintf(stderr, "test_fs: failed on test setup\n");
 		return err;
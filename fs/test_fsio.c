@@ -0,0 +1,301 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Filesystem data path benchmark - sequential and random read/write of a large file
+ * with and without fsync/fdatasync/O_SYNC
+ *
+ * Copyright 2025 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include "errno.h"
+#include "fcntl.h"
+#include "inttypes.h"
+#include "stdint.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "time.h"
+#include "unistd.h"
+
+#include "sys/stat.h"
+
+
+/* Host build definitions */
+#ifndef EOK
+#define EOK 0
+#endif
+
+
+/* Misc definitions */
+#define FILE_NAME     "test_fsio_XXXXXX" /* Test file name template */
+#define FILE_NAME_FMT "%s/" FILE_NAME    /* Test file path format */
+#define FILE_SIZE     16                 /* Default test file size in MB */
+#define XFER_MIN      (4 << 10)          /* Min transfer size */
+#define XFER_MAX      (1 << 20)          /* Max transfer size */
+#define SYNC_OPS      256                /* Max number of synchronized writes per test */
+
+
+/* Synchronization modes */
+enum { sync_none = 0, sync_fsync, sync_fdatasync, sync_osync, sync_modes };
+
+
+static const char *const syncs[] = { "none", "fsync", "fdatasync", "O_SYNC" };
+
+
+typedef struct {
+	char *path;     /* Test file path */
+	uint64_t fsize; /* Test file size */
+	uint8_t *buff;  /* Transfer buffer */
+	uint32_t *lat;  /* Operations latencies in nsec */
+	uint32_t seed;  /* Random offsets generator state */
+} test_fsio_state_t;
+
+
+/* Returns monotonic time in nsec */
+static uint64_t test_fsio_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+/* xorshift32 */
+static uint32_t test_fsio_rand(uint32_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+
+	return *seed;
+}
+
+
+static int test_fsio_cmp(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+
+/* Checks if synchronization mode is supported */
+static int test_fsio_syncmode(int sync)
+{
+	switch (sync) {
+#ifndef _POSIX_SYNCHRONIZED_IO
+	case sync_fdatasync:
+		return 0;
+#endif
+
+#ifndef O_SYNC
+	case sync_osync:
+		return 0;
+#endif
+
+	default:
+		return 1;
+	}
+}
+
+
+/* Performs single write followed by the synchronization */
+static int test_fsio_write(int fd, const uint8_t *buff, uint64_t len, int sync)
+{
+	if (write(fd, buff, len) != len)
+		return -EIO;
+
+	switch (sync) {
+	case sync_fsync:
+		if (fsync(fd) < 0)
+			return -EIO;
+		break;
+
+#ifdef _POSIX_SYNCHRONIZED_IO
+	case sync_fdatasync:
+		if (fdatasync(fd) < 0)
+			return -EIO;
+		break;
+#endif
+
+	default:
+		break;
+	}
+
+	return EOK;
+}
+
+
+/* Runs one test, reports throughput and latency percentiles of the read or write(+sync) calls */
+static int test_fsio_one(test_fsio_state_t *state, int wr, int rnd, int sync, uint64_t xfer)
+{
+	uint64_t i, offs, start, t, time = 0, n = state->fsize / xfer;
+	int fd, flags = wr ? O_WRONLY : O_RDONLY;
+	int err = EOK;
+
+	/* Synchronized writes are slow on flash, limit their number */
+	if ((sync != sync_none) && (n > SYNC_OPS))
+		n = SYNC_OPS;
+
+#ifdef O_SYNC
+	if (sync == sync_osync)
+		flags |= O_SYNC;
+#endif
+
+	if ((fd = open(state->path, flags)) < 0) {
+		fprintf(stderr, "test_fsio: failed to open file %s\n", state->path);
+		return -EIO;
+	}
+
+	for (i = 0; i < n; i++) {
+		offs = (rnd ? test_fsio_rand(&state->seed) % (state->fsize / xfer) : i) * xfer;
+
+		start = test_fsio_nsec();
+
+		if (lseek(fd, (off_t)offs, SEEK_SET) < 0) {
+			fprintf(stderr, "test_fsio: bad lseek at offs=%" PRIu64 "\n", offs);
+			err = -EINVAL;
+			break;
+		}
+
+		if (wr)
+			err = test_fsio_write(fd, state->buff, xfer, sync);
+		else if (read(fd, state->buff, xfer) != xfer)
+			err = -EIO;
+
+		if (err < 0) {
+			fprintf(stderr, "test_fsio: IO error at offs=%" PRIu64 "\n", offs);
+			break;
+		}
+
+		t = test_fsio_nsec() - start;
+		state->lat[i] = (t > UINT32_MAX) ? UINT32_MAX : (uint32_t)t;
+		time += t;
+	}
+
+	if ((close(fd) < 0) && (err == EOK))
+		err = -EIO;
+
+	if (err < 0)
+		return err;
+
+	if (!time)
+		time = 1;
+
+	qsort(state->lat, n, sizeof(*state->lat), test_fsio_cmp);
+
+	printf("| %-5s | %-4s | %-9s | %5" PRIu64 "K | %9.2f | %10" PRIu32 " | %10" PRIu32 " | %10" PRIu32 " |\n",
+		wr ? "write" : "read", rnd ? "rand" : "seq", syncs[sync], xfer >> 10, (double)n * xfer * 1000000000 / time / (1 << 20),
+		state->lat[n / 2], state->lat[n * 99 / 100], state->lat[n - 1]);
+
+	return EOK;
+}
+
+
+/* Runs all tests on the file in dir */
+static int test_fsio_run(test_fsio_state_t *state, const char *dir)
+{
+	uint64_t xfer;
+	int fd, sync, err = EOK;
+
+	if ((state->path = malloc(strlen(dir) + sizeof(FILE_NAME) + 1)) == NULL)
+		return -ENOMEM;
+	sprintf(state->path, FILE_NAME_FMT, dir);
+
+	if ((fd = mkstemp(state->path)) < 0) {
+		fprintf(stderr, "test_fsio: failed to create file in %s\n", dir);
+		free(state->path);
+		return -EEXIST;
+	}
+	close(fd);
+
+	printf("test_fsio: %s, %" PRIu64 "MB file, throughput in MB/s, latencies in ns\n", dir, state->fsize >> 20);
+	printf("|  OP   | MODE |   SYNC    | BLOCK  |   MB/s    |    P50     |    P99     |    MAX     |\n");
+
+	for (xfer = XFER_MIN; (err == EOK) && (xfer <= XFER_MAX) && (xfer <= state->fsize); xfer <<= 2) {
+		/* Sequential write lays out the whole file first */
+		if (((err = test_fsio_one(state, 1, 0, sync_none, xfer)) < 0) ||
+			((err = test_fsio_one(state, 0, 0, sync_none, xfer)) < 0) ||
+			((err = test_fsio_one(state, 1, 1, sync_none, xfer)) < 0) ||
+			((err = test_fsio_one(state, 0, 1, sync_none, xfer)) < 0))
+			break;
+
+		for (sync = sync_fsync; sync < sync_modes; sync++) {
+			if (!test_fsio_syncmode(sync))
+				continue;
+
+			if (((err = test_fsio_one(state, 1, 0, sync, xfer)) < 0) ||
+				((err = test_fsio_one(state, 1, 1, sync, xfer)) < 0))
+				break;
+		}
+	}
+
+	unlink(state->path);
+	free(state->path);
+
+	return err;
+}
+
+
+static void test_fsio_usage(const char *progname)
+{
+	printf("Usage: %s [options] <dir> [<dir> ...]\n", progname);
+	printf("  -s SIZE   test file size in MB (default: %u)\n", FILE_SIZE);
+}
+
+
+int main(int argc, char *argv[])
+{
+	test_fsio_state_t state = { .fsize = (uint64_t)FILE_SIZE << 20, .seed = 2463534242U };
+	int c, i, err = EOK;
+
+	while ((c = getopt(argc, argv, "s:h")) != -1) {
+		switch (c) {
+		case 's':
+			state.fsize = strtoull(optarg, NULL, 0) << 20;
+			break;
+
+		default:
+			test_fsio_usage(argv[0]);
+			return EOK;
+		}
+	}
+
+	if ((optind >= argc) || (state.fsize < XFER_MIN)) {
+		test_fsio_usage(argv[0]);
+		return EOK;
+	}
+
+	printf("test_fsio: starting, main is at %p\n", main);
+
+	if ((state.buff = malloc(XFER_MAX)) == NULL) {
+		fprintf(stderr, "test_fsio: failed to allocate memory\n");
+		return -ENOMEM;
+	}
+	memset(state.buff, 0x5a, XFER_MAX);
+
+	if ((state.lat = malloc(state.fsize / XFER_MIN * sizeof(*state.lat))) == NULL) {
+		fprintf(stderr, "test_fsio: failed to allocate memory\n");
+		free(state.buff);
+		return -ENOMEM;
+	}
+
+	/* Compare filesystems mounted at the given directories, e.g. ramdisk /tmp and rootfs */
+	for (i = optind; i < argc; i++) {
+		if ((c = test_fsio_run(&state, argv[i])) < 0) {
+			fprintf(stderr, "test_fsio: test failed on %s\n", argv[i]);
+			err = c;
+		}
+	}
+
+	free(state.lat);
+	free(state.buff);
+
+	return err;
+}
@@ -11,9 +11,17 @@
  * %LICENSE%
  */
 
+/* CPU affinity API of glibc (used on host-generic-pc if available) */
+#define _GNU_SOURCE
+
 #include <time.h>
+#include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include <pthread.h>
+#include <sched.h>
 #include <lf-fifo.h>
 
 #include "unity_fixture.h"
@@ -21,8 +29,14 @@
 
 #define MAX_FIFO_SIZE 8192
 
-#define SPEED_TEST_OPS  1000000
-#define SPEED_TEST_MOPS (SPEED_TEST_OPS / 1000000)
+#define SPEED_TEST_OPS 1000000
+
+/* scaling benchmark: independent producer-consumer pairs, each with its own fifo */
+#define SCALING_FIFO_SIZE   1024
+#define SCALING_MAX_PAIRS   4
+#define SCALING_OPS         100000
+#define SCALING_LAT_PERIOD  64 /* every n-th push is timed */
+#define SCALING_LAT_SAMPLES (SCALING_OPS / SCALING_LAT_PERIOD + 1)
 
 typedef enum {
 	speedtest_push_pop = 0,
@@ -36,6 +50,21 @@ static lf_fifo_t fifo;
 
 static uint8_t tmpbuf[MAX_FIFO_SIZE * 2];
 
+typedef struct {
+	lf_fifo_t fifo;
+	uint8_t buffer[SCALING_FIFO_SIZE];
+	unsigned int payload;
+	int producer_cpu, consumer_cpu; /* -1 - not pinned */
+	volatile int pin_err;
+	volatile int stop; /* Run aborted, the other thread of the pair might not exist */
+	pthread_t producer, consumer;
+	unsigned int nsamples;
+	uint32_t latency[SCALING_LAT_SAMPLES]; /* push latency in ns */
+} __attribute__((aligned(64))) scaling_pair_t;
+
+static scaling_pair_t pairs[SCALING_MAX_PAIRS];
+static uint32_t latencies[SCALING_MAX_PAIRS * SCALING_LAT_SAMPLES];
+
 
 TEST_GROUP(test_lf_fifo);
 
@@ -584,7 +613,8 @@ static const char *speedtest_name(speedtest_t type)
 }
 
 
-static void test_push_pop_speed(unsigned int size, speedtest_t type)
+/* Returns throughput of a single producer-consumer run in ops/sec */
+static double push_pop_speed(unsigned int size, speedtest_t type)
 {
 	struct timespec ts1, ts2;
 	pthread_t producer, consumer;
@@ -600,16 +630,262 @@ static void test_push_pop_speed(unsigned int size, speedtest_t type)
 
 	clock_gettime(CLOCK_MONOTONIC, &ts2);
 
-	unsigned int usec = (ts2.tv_sec - ts1.tv_sec) * 1000000 + (ts2.tv_nsec - ts1.tv_nsec) / 1000;
-	unsigned int sec = usec / 1000000;
-	unsigned int msec = (usec % 1000000) / 1000;
-	unsigned int mops = SPEED_TEST_OPS / usec;
+	double sec = (double)(ts2.tv_sec - ts1.tv_sec) + (double)(ts2.tv_nsec - ts1.tv_nsec) / 1e9;
+
+	return SPEED_TEST_OPS / sec;
+}
+
+
+static void test_push_pop_speed(unsigned int size, speedtest_t type)
+{
+	char name[32];
+
+	snprintf(name, sizeof(name), "%s.fifo%u", speedtest_name(type), size);
+
+	/* single runs vary a lot (especially under QEMU), report statistics of multiple runs */
+	BENCHMARK(name, "ops/s", 1)
+	{
+		UnityBenchmarkSample(push_pop_speed(size, type));
+	}
+}
+
+
+static uint64_t scaling_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+static int scaling_pinning_supported(void)
+{
+#ifdef CPU_SET
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+
+static int scaling_pin(int cpu)
+{
+#ifdef CPU_SET
+	cpu_set_t set;
+
+	if (cpu >= 0) {
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	}
+#else
+	(void)cpu;
+#endif
+	return 0;
+}
+
+
+/* Returns number of online CPUs or 0 if unknown */
+static unsigned int scaling_cpus(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	if (n > 0) {
+		return (unsigned int)n;
+	}
+#endif
+	return 0;
+}
+
+
+static void *scaling_producer(void *arg)
+{
+	scaling_pair_t *pair = arg;
+	uint8_t msg[SCALING_FIFO_SIZE / 4] = { 0 };
+	unsigned int op, pushed;
+	uint64_t start;
+
+	if (scaling_pin(pair->producer_cpu) != 0) {
+		pair->pin_err = 1;
+	}
+
+	for (op = 0; (op < SCALING_OPS) && (pair->stop == 0); op++) {
+		start = (op % SCALING_LAT_PERIOD == 0) ? scaling_now() : 0;
+
+		/* a message may be pushed in parts if there is not enough free space */
+		pushed = 0;
+		while ((pushed < pair->payload) && (pair->stop == 0)) {
+			pushed += lf_fifo_push_many(&pair->fifo, msg + pushed, pair->payload - pushed);
+		}
+
+		if (start != 0) {
+			pair->latency[pair->nsamples++] = (uint32_t)(scaling_now() - start);
+		}
+	}
+
+	return NULL;
+}
+
+
+static void *scaling_consumer(void *arg)
+{
+	scaling_pair_t *pair = arg;
+	uint8_t msg[SCALING_FIFO_SIZE / 4];
+	unsigned long total = (unsigned long)SCALING_OPS * pair->payload;
+	unsigned long popped = 0;
+
+	if (scaling_pin(pair->consumer_cpu) != 0) {
+		pair->pin_err = 1;
+	}
+
+	while ((popped < total) && (pair->stop == 0)) {
+		popped += lf_fifo_pop_many(&pair->fifo, msg, pair->payload);
+	}
+
+	return NULL;
+}
+
+
+/* Stops and joins threads of the first npairs pairs, used when not all of them could be created */
+static void scaling_abort(unsigned int npairs)
+{
+	unsigned int i;
+
+	for (i = 0; i < npairs; i++) {
+		pairs[i].stop = 1;
+	}
+
+	for (i = 0; i < npairs; i++) {
+		pthread_join(pairs[i].producer, NULL);
+		pthread_join(pairs[i].consumer, NULL);
+	}
+}
+
+
+/* Returns total throughput of all pairs in messages/sec */
+static double scaling_run(unsigned int npairs, unsigned int payload, int pinned, unsigned int ncpus)
+{
+	uint64_t start, end;
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < npairs; i++) {
+		lf_fifo_init(&pairs[i].fifo, pairs[i].buffer, SCALING_FIFO_SIZE);
+		pairs[i].payload = payload;
+		pairs[i].producer_cpu = pinned ? (int)((2 * i) % ncpus) : -1;
+		pairs[i].consumer_cpu = pinned ? (int)((2 * i + 1) % ncpus) : -1;
+		pairs[i].pin_err = 0;
+		pairs[i].stop = 0;
+		pairs[i].nsamples = 0;
+	}
+
+	start = scaling_now();
+
+	for (i = 0; i < npairs; i++) {
+		ret = pthread_create(&pairs[i].producer, NULL, scaling_producer, &pairs[i]);
+		if (ret == 0) {
+			ret = pthread_create(&pairs[i].consumer, NULL, scaling_consumer, &pairs[i]);
+			if (ret != 0) {
+				pairs[i].stop = 1;
+				pthread_join(pairs[i].producer, NULL);
+			}
+		}
+
+		/* failed assertion doesn't return, threads without their pair would spin forever */
+		if (ret != 0) {
+			scaling_abort(i);
+			TEST_ASSERT_EQUAL_INT(0, ret);
+		}
+	}
+
+	for (i = 0; i < npairs; i++) {
+		pthread_join(pairs[i].producer, NULL);
+		pthread_join(pairs[i].consumer, NULL);
+	}
+
+	end = scaling_now();
+
+	for (i = 0; i < npairs; i++) {
+		TEST_ASSERT_EQUAL_INT_MESSAGE(0, pairs[i].pin_err, "Setting thread CPU affinity failed");
+	}
+
+	return (double)npairs * SCALING_OPS * 1e9 / (double)(end - start);
+}
+
+
+static int scaling_latency_cmp(const void *a, const void *b)
+{
+	uint32_t la = *(const uint32_t *)a, lb = *(const uint32_t *)b;
+
+	return (la > lb) - (la < lb);
+}
+
+
+/* Prints percentiles of push latencies collected in the last run */
+static void scaling_report_latency(const char *name, unsigned int npairs)
+{
+	unsigned int i, n = 0;
+
+	for (i = 0; i < npairs; i++) {
+		memcpy(&latencies[n], pairs[i].latency, pairs[i].nsamples * sizeof(latencies[0]));
+		n += pairs[i].nsamples;
+	}
+
+	if (n == 0) {
+		return;
+	}
+
+	qsort(latencies, n, sizeof(latencies[0]), scaling_latency_cmp);
 
-	printf("%s: fifo %u, %u.%3.3u sec, %u mops/sec\n", speedtest_name(type), size, sec, msec, mops);
+	printf("METRIC name=%s.push_p50 value=%u unit=ns better=lower\n", name, (unsigned int)latencies[n / 2]);
+	printf("METRIC name=%s.push_p99 value=%u unit=ns better=lower\n", name,
+		(unsigned int)latencies[(99 * n + 99) / 100 - 1]);
+	printf("METRIC name=%s.push_max value=%u unit=ns better=lower\n", name, (unsigned int)latencies[n - 1]);
 }
 
 
-TEST(test_lf_fifo, speed_push_pop)
+static void test_scaling(unsigned int npairs, unsigned int payload, int pinned, unsigned int ncpus)
+{
+	char name[48];
+
+	snprintf(name, sizeof(name), "scaling.pairs%u.payload%u%s", npairs, payload, pinned ? ".pinned" : "");
+
+	BENCHMARK(name, "msg/s", 1)
+	{
+		UnityBenchmarkSample(scaling_run(npairs, payload, pinned, ncpus));
+	}
+
+	scaling_report_latency(name, npairs);
+}
+
+
+BENCH_TEST(test_lf_fifo, speed_scaling_push_pop_many)
+{
+	static const unsigned int payloads[] = { 1, 16, 64, 256 };
+	unsigned int ncpus = scaling_cpus();
+	unsigned int maxpairs = SCALING_MAX_PAIRS;
+	unsigned int npairs, i;
+	int pinned, maxpinned;
+
+	/* don't oversubscribe CPUs if their number is known, spinning threads would starve each other */
+	if ((ncpus != 0) && (ncpus / 2 < maxpairs)) {
+		maxpairs = (ncpus > 1) ? ncpus / 2 : 1;
+	}
+	maxpinned = (scaling_pinning_supported() && (ncpus != 0)) ? 1 : 0;
+
+	for (pinned = 0; pinned <= maxpinned; pinned++) {
+		for (npairs = 1; npairs <= maxpairs; npairs *= 2) {
+			for (i = 0; i < sizeof(payloads) / sizeof(payloads[0]); i++) {
+				test_scaling(npairs, payloads[i], pinned, ncpus);
+			}
+		}
+	}
+}
+
+
+BENCH_TEST(test_lf_fifo, speed_push_pop)
 {
 	unsigned int i;
 
@@ -619,7 +895,7 @@ TEST(test_lf_fifo, speed_push_pop)
 }
 
 
-TEST(test_lf_fifo, speed_push_pop_many)
+BENCH_TEST(test_lf_fifo, speed_push_pop_many)
 {
 	unsigned int i;
 
@@ -629,7 +905,7 @@ TEST(test_lf_fifo, speed_push_pop_many)
 }
 
 
-TEST(test_lf_fifo, speed_ow_push_pop)
+BENCH_TEST(test_lf_fifo, speed_ow_push_pop)
 {
 	unsigned int i;
 
@@ -639,7 +915,7 @@ TEST(test_lf_fifo, speed_ow_push_pop)
 }
 
 
-TEST(test_lf_fifo, speed_ow_push_pop_many)
+BENCH_TEST(test_lf_fifo, speed_ow_push_pop_many)
 {
 	unsigned int i;
 
@@ -658,12 +934,11 @@ TEST_GROUP_RUNNER(test_lf_fifo)
 	RUN_TEST_CASE(test_lf_fifo, ow_push);
 	RUN_TEST_CASE(test_lf_fifo, ow_push_many);
 	RUN_TEST_CASE(test_lf_fifo, ow_pop_many);
-#if 0
 	RUN_TEST_CASE(test_lf_fifo, speed_push_pop);
 	RUN_TEST_CASE(test_lf_fifo, speed_push_pop_many);
 	RUN_TEST_CASE(test_lf_fifo, speed_ow_push_pop);
 	RUN_TEST_CASE(test_lf_fifo, speed_ow_push_pop_many);
-#endif
+	RUN_TEST_CASE(test_lf_fifo, speed_scaling_push_pop_many);
 }
 
 
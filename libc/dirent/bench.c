@@ -0,0 +1,241 @@
+/*
+ * Phoenix-RTOS
+ *
+ * POSIX.1-2017 standard library functions benchmarks
+ * HEADER:
+ *    - dirent.h
+ * MEASURED:
+ *    - readdir() entries/s in directories with 1k..100k entries
+ *    - rewinddir(), telldir() and seekdir() latency
+ *    - heap memory held by an open DIR stream
+ *
+ * Copyright 2025 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <malloc.h>
+#include <string.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <time.h>
+
+#include <unity_fixture.h>
+#include "dirent_helper_functions.h"
+
+#include "common.h"
+
+#define MAIN_DIR        "test_dirent_bench"
+#define BENCH_POSITIONS 256 /* Number of telldir() positions to seek to */
+
+static const unsigned int entryCounts[] = { 1000, 10000, 100000 };
+
+static struct {
+	unsigned int entries; /* Number of files created in MAIN_DIR */
+	long pos[BENCH_POSITIONS];
+	char names[BENCH_POSITIONS][NAME_MAX + 1];
+} bench_ctx;
+
+
+static uint64_t bench_nowNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+/* Adds files to MAIN_DIR until it holds the given number of entries */
+static void bench_populate(unsigned int entries)
+{
+	char path[32];
+	int fd;
+
+	for (; bench_ctx.entries < entries; bench_ctx.entries++) {
+		sprintf(path, MAIN_DIR "/e%u", bench_ctx.entries);
+		fd = open(path, O_WRONLY | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+		TEST_ASSERT_GREATER_OR_EQUAL_INT(0, fd);
+		close(fd);
+	}
+}
+
+
+/* Reads the rest of the directory, returns number of entries read */
+static unsigned int bench_scan(DIR *dp)
+{
+	unsigned int n = 0;
+
+	errno = 0;
+	while (readdir(dp) != NULL) {
+		n++;
+	}
+	TEST_ASSERT_EQUAL_INT(0, errno);
+
+	return n;
+}
+
+
+/* Full scan of the directory, as done by housekeeping jobs */
+static void bench_readdir(unsigned int entries)
+{
+	uint64_t start;
+	unsigned int n = 0;
+	char name[48];
+	DIR *dp;
+
+	sprintf(name, "readdir.entries%u", entries);
+
+	BENCHMARK(name, "entries/s", 1)
+	{
+		start = bench_nowNs();
+		dp = TEST_OPENDIR_ASSERTED(MAIN_DIR);
+		n = bench_scan(dp);
+		closedir(dp);
+		UnityBenchmarkSample(n * 1e9 / (bench_nowNs() - start));
+	}
+
+	/* "." and ".." are not listed by every filesystem */
+	TEST_ASSERT_GREATER_OR_EQUAL_UINT(entries, n);
+	TEST_ASSERT_LESS_OR_EQUAL_UINT(entries + 2, n);
+}
+
+
+/* rewinddir() at the end of the directory followed by the read of the first entry */
+static void bench_rewinddir(unsigned int entries)
+{
+	uint64_t start;
+	char name[48];
+	DIR *dp;
+
+	sprintf(name, "rewinddir.entries%u", entries);
+	dp = TEST_OPENDIR_ASSERTED(MAIN_DIR);
+
+	BENCHMARK(name, "ns", 0)
+	{
+		bench_scan(dp);
+
+		start = bench_nowNs();
+		rewinddir(dp);
+		TEST_ASSERT_NOT_NULL(readdir(dp));
+		UnityBenchmarkSample((double)(bench_nowNs() - start));
+	}
+
+	closedir(dp);
+}
+
+
+/* telldir() of every entry, seekdir() + readdir() of evenly spaced entries in pseudo-random order */
+static void bench_seekdir(unsigned int entries)
+{
+	unsigned int i, j, n = 0, npos = 0, step = entries / BENCH_POSITIONS + 1;
+	uint64_t start, tellNs = 0, sum;
+	struct dirent *d;
+	char name[48];
+	long pos;
+	DIR *dp;
+
+	dp = TEST_OPENDIR_ASSERTED(MAIN_DIR);
+
+	for (;;) {
+		start = bench_nowNs();
+		pos = telldir(dp);
+		tellNs += bench_nowNs() - start;
+
+		if ((d = readdir(dp)) == NULL) {
+			break;
+		}
+
+		if (((n++ % step) == 0) && (npos < BENCH_POSITIONS)) {
+			bench_ctx.pos[npos] = pos;
+			memcpy(bench_ctx.names[npos], d->d_name, strlen(d->d_name) + 1);
+			npos++;
+		}
+	}
+	TEST_ASSERT_NOT_EQUAL_UINT(0, npos);
+
+	printf("METRIC name=telldir.entries%u value=%.0f unit=ns better=lower\n", entries, (double)tellNs / (n + 1));
+
+	sprintf(name, "seekdir.entries%u", entries);
+
+	BENCHMARK(name, "ns", 0)
+	{
+		sum = 0;
+		for (i = 0; i < npos; i++) {
+			/* 7919 is a prime, so it's coprime with npos and every position is visited once */
+			j = (i * 7919U) % npos;
+
+			start = bench_nowNs();
+			seekdir(dp, bench_ctx.pos[j]);
+			d = readdir(dp);
+			sum += bench_nowNs() - start;
+
+			TEST_ASSERT_NOT_NULL(d);
+			TEST_ASSERT_EQUAL_STRING(bench_ctx.names[j], d->d_name);
+		}
+		UnityBenchmarkSample((double)sum / npos);
+	}
+
+	closedir(dp);
+}
+
+
+/* Size of the heap block of a DIR stream after the whole directory is read */
+static void bench_memory(unsigned int entries)
+{
+	DIR *dp = TEST_OPENDIR_ASSERTED(MAIN_DIR);
+
+	bench_scan(dp);
+	printf("METRIC name=dir_bytes.entries%u value=%zu unit=B better=lower\n", entries, malloc_usable_size(dp));
+
+	closedir(dp);
+}
+
+
+TEST_GROUP(dirent_bench);
+
+TEST_SETUP(dirent_bench)
+{
+	memset(&bench_ctx, 0, sizeof(bench_ctx));
+	TEST_MKDIR_ASSERTED(MAIN_DIR, S_IRWXU);
+}
+
+
+TEST_TEAR_DOWN(dirent_bench)
+{
+	char path[32];
+
+	while (bench_ctx.entries > 0) {
+		sprintf(path, MAIN_DIR "/e%u", --bench_ctx.entries);
+		unlink(path);
+	}
+	rmdir(MAIN_DIR);
+}
+
+
+BENCH_TEST(dirent_bench, large_dirs)
+{
+	unsigned int i;
+
+	for (i = 0; i < sizeof(entryCounts) / sizeof(entryCounts[0]); i++) {
+		bench_populate(entryCounts[i]);
+
+		bench_readdir(entryCounts[i]);
+		bench_rewinddir(entryCounts[i]);
+		bench_seekdir(entryCounts[i]);
+		bench_memory(entryCounts[i]);
+	}
+}
+
+
+TEST_GROUP_RUNNER(dirent_bench)
+{
+	RUN_TEST_CASE(dirent_bench, large_dirs);
+}
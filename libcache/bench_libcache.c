@@ -0,0 +1,551 @@
+/*
+ * Phoenix-RTOS
+ *
+ * phoenix-rtos-tests
+ *
+ * Libcache benchmarks
+ *
+ * Copyright 2025 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include "libcache_utils.h"
+
+#include "unity_fixture.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+
+#define BENCH_SRC_MEM_SIZE (128 * 1024) /* Size of the memory-backed source */
+#define BENCH_ACCESS_SIZE  16           /* Size of a single read/write, smaller than any swept line size */
+#define BENCH_OPS          20000        /* Number of reads/writes in a single run */
+#define BENCH_ZIPF_S       0.99         /* Skew of the Zipfian distribution */
+#define BENCH_BLOCKS       (BENCH_SRC_MEM_SIZE / BENCH_ACCESS_SIZE)
+
+#define BENCH_MAX_THREADS  8
+#define BENCH_THREAD_OPS   5000 /* Number of reads/writes of a single thread */
+
+
+typedef enum {
+	pattern_sequential = 0,
+	pattern_strided,
+	pattern_random,
+	pattern_zipfian,
+	pattern_count
+} bench_pattern_t;
+
+
+typedef struct {
+	pthread_t tid;
+	pthread_t self;     /* Set by the thread itself, tid may not be stored yet when it starts */
+	volatile int ready; /* self is valid */
+	unsigned int idx;
+	int write;
+	uint64_t rangeStart;
+	uint64_t rangeSize;
+	uint32_t seed;
+	uint64_t blocked; /* Time waiting for contended mutexes, in ns */
+	uint32_t latency[BENCH_THREAD_OPS]; /* in ns */
+} bench_thread_t;
+
+
+typedef struct {
+	unsigned long readCalls;
+	unsigned long writeCalls;
+	unsigned long long readBytes;
+	unsigned long long writeBytes;
+} bench_stats_t;
+
+
+static cache_ops_t ops;
+static uint8_t *srcMemBuf;
+static bench_stats_t stats;
+static double *zipfCdf;
+static uint32_t seed;
+static cachectx_t *sharedCache;
+static bench_thread_t threads[BENCH_MAX_THREADS];
+static unsigned int threadsCnt; /* Threads of the running workload */
+static uint32_t latencies[BENCH_MAX_THREADS * BENCH_THREAD_OPS];
+
+
+/* Backing store kept in memory, so only the cache itself and the number of callbacks are measured */
+static ssize_t bench_readCb(uint64_t offset, void *buffer, size_t count, cache_devCtx_t *ctx)
+{
+	(void)ctx;
+
+	memcpy(buffer, srcMemBuf + offset, count);
+	stats.readCalls++;
+	stats.readBytes += count;
+
+	return count;
+}
+
+
+static ssize_t bench_writeCb(uint64_t offset, const void *buffer, size_t count, cache_devCtx_t *ctx)
+{
+	(void)ctx;
+
+	memcpy(srcMemBuf + offset, buffer, count);
+	stats.writeCalls++;
+	stats.writeBytes += count;
+
+	return count;
+}
+
+
+/* xorshift32 - deterministic and cheap compared to the measured operations */
+static uint32_t bench_randState(uint32_t *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+
+	return *state;
+}
+
+
+static uint32_t bench_rand(void)
+{
+	return bench_randState(&seed);
+}
+
+
+static double bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+
+/* Cumulative distribution of block popularity: P(block k) ~ 1 / (k + 1)^s */
+static void bench_zipfInit(void)
+{
+	double sum = 0.0;
+	unsigned int k;
+
+	for (k = 0; k < BENCH_BLOCKS; k++) {
+		sum += 1.0 / pow((double)(k + 1), BENCH_ZIPF_S);
+		zipfCdf[k] = sum;
+	}
+
+	for (k = 0; k < BENCH_BLOCKS; k++) {
+		zipfCdf[k] /= sum;
+	}
+}
+
+
+static unsigned int bench_zipfNext(void)
+{
+	double u = (double)bench_rand() / 4294967296.0;
+	unsigned int lo = 0, hi = BENCH_BLOCKS - 1, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (zipfCdf[mid] < u) {
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
+		}
+	}
+
+	/* scatter popular blocks over the whole source, otherwise they would share a few cache lines */
+	return (lo * 2654435761u) % BENCH_BLOCKS;
+}
+
+
+static uint64_t bench_nextAddr(bench_pattern_t pattern, unsigned int op, size_t lineSize)
+{
+	unsigned int block;
+
+	switch (pattern) {
+		case pattern_sequential:
+			block = op % BENCH_BLOCKS;
+			break;
+
+		case pattern_strided:
+			/* one access per cache line, skipping every other line */
+			block = (op * 2 * (lineSize / BENCH_ACCESS_SIZE)) % BENCH_BLOCKS;
+			break;
+
+		case pattern_random:
+			block = bench_rand() % BENCH_BLOCKS;
+			break;
+
+		case pattern_zipfian:
+			block = bench_zipfNext();
+			break;
+
+		default:
+			TEST_ABORT();
+	}
+
+	return (uint64_t)block * BENCH_ACCESS_SIZE;
+}
+
+
+static const char *bench_patternName(bench_pattern_t pattern)
+{
+	switch (pattern) {
+		case pattern_sequential:
+			return "seq";
+		case pattern_strided:
+			return "stride";
+		case pattern_random:
+			return "random";
+		case pattern_zipfian:
+			return "zipf";
+		default:
+			TEST_ABORT();
+	}
+}
+
+
+/* Returns ops/sec of a single run on a cold cache */
+static double bench_run(size_t lineSize, size_t linesCnt, bench_pattern_t pattern, int write)
+{
+	uint8_t buf[BENCH_ACCESS_SIZE] = { 0 };
+	cachectx_t *cache;
+	unsigned int op;
+	double start, end;
+	ssize_t ret;
+
+	cache = cache_init(BENCH_SRC_MEM_SIZE, lineSize, linesCnt, &ops);
+	TEST_ASSERT_NOT_NULL(cache);
+
+	memset(&stats, 0, sizeof(stats));
+	seed = 2463534242u;
+
+	start = bench_now();
+
+	for (op = 0; op < BENCH_OPS; op++) {
+		uint64_t addr = bench_nextAddr(pattern, op, lineSize);
+
+		if (write) {
+			ret = cache_write(cache, addr, buf, sizeof(buf), LIBCACHE_WRITE_BACK);
+		}
+		else {
+			ret = cache_read(cache, addr, buf, sizeof(buf));
+		}
+		TEST_ASSERT_EQUAL_INT(sizeof(buf), ret);
+	}
+
+	end = bench_now();
+
+	/* write back of dirty lines is not a part of the measured workload */
+	TEST_ASSERT_EQUAL_INT(EOK, cache_deinit(cache));
+
+	return BENCH_OPS / (end - start);
+}
+
+
+static void bench_cache(size_t lineSize, size_t linesCnt, bench_pattern_t pattern, int write)
+{
+	char name[64];
+	double ops_s = 0.0;
+
+	snprintf(name, sizeof(name), "%s.%s.line%zu.lines%zu",
+		write ? "write" : "read", bench_patternName(pattern), lineSize, linesCnt);
+
+	BENCHMARK(name, "ops/s", 1)
+	{
+		ops_s = bench_run(lineSize, linesCnt, pattern, write);
+		UnityBenchmarkSample(ops_s);
+	}
+
+	/*
+	 * Every access fits in a single line, so each read callback is a miss
+	 * (including line fills on write misses). Callback counts are deterministic for a given pattern.
+	 */
+	printf("METRIC name=%s.hit_ratio value=%.4f better=higher\n", name, 1.0 - (double)stats.readCalls / BENCH_OPS);
+	printf("METRIC name=%s.bytes_rate value=%.0f unit=B/s better=higher\n", name, ops_s * BENCH_ACCESS_SIZE);
+	printf("METRIC name=%s.callbacks_per_op value=%.4f better=lower\n", name,
+		(double)(stats.readCalls + stats.writeCalls) / BENCH_OPS);
+}
+
+
+static uint64_t bench_nowNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+/* Benchmark thread calling the function, NULL for the main thread or when no workload is running */
+static bench_thread_t *bench_threadSelf(void)
+{
+	pthread_t self = pthread_self();
+	unsigned int i;
+
+	for (i = 0; i < threadsCnt; i++) {
+		if ((threads[i].ready != 0) && (pthread_equal(threads[i].self, self) != 0)) {
+			return &threads[i];
+		}
+	}
+
+	return NULL;
+}
+
+
+/*
+ * libcache doesn't expose its lock, test is linked with --wrap=pthread_mutex_lock,
+ * so the time spent waiting for a mutex held by another thread is measured
+ * for the mutexes locked inside the cache operations.
+ */
+int __real_pthread_mutex_lock(pthread_mutex_t *mutex);
+
+
+int __wrap_pthread_mutex_lock(pthread_mutex_t *mutex)
+{
+	bench_thread_t *thread = bench_threadSelf();
+	uint64_t start;
+	int ret;
+
+	if (thread == NULL) {
+		return __real_pthread_mutex_lock(mutex);
+	}
+
+	ret = pthread_mutex_trylock(mutex);
+	if (ret != EBUSY) {
+		return ret;
+	}
+
+	start = bench_nowNs();
+	ret = __real_pthread_mutex_lock(mutex);
+	thread->blocked += bench_nowNs() - start;
+
+	return ret;
+}
+
+
+/* Random accesses within the thread's range, each operation is timed */
+static void *bench_thread(void *arg)
+{
+	bench_thread_t *thread = arg;
+	uint8_t buf[BENCH_ACCESS_SIZE];
+	test_write_args_t wargs = {
+		.cache = sharedCache, .buffer = buf, .count = sizeof(buf), .policy = LIBCACHE_WRITE_BACK
+	};
+	test_read_args_t rargs = { .cache = sharedCache, .buffer = buf, .count = sizeof(buf) };
+	uint64_t blocks = thread->rangeSize / BENCH_ACCESS_SIZE;
+	uint64_t start;
+	unsigned int op;
+
+	memset(buf, (int)thread->idx, sizeof(buf));
+
+	thread->self = pthread_self();
+	thread->ready = 1;
+
+	for (op = 0; op < BENCH_THREAD_OPS; op++) {
+		uint64_t addr = thread->rangeStart + (bench_randState(&thread->seed) % blocks) * BENCH_ACCESS_SIZE;
+
+		start = bench_nowNs();
+		if (thread->write) {
+			wargs.addr = addr;
+			test_cache_write(&wargs);
+		}
+		else {
+			rargs.addr = addr;
+			test_cache_read(&rargs);
+		}
+		thread->latency[op] = (uint32_t)(bench_nowNs() - start);
+
+		/* can't use assertions outside of the main thread, mark the failure with an invalid latency */
+		if ((thread->write ? wargs.actualCount : rargs.actualCount) != sizeof(buf)) {
+			thread->latency[op] = UINT32_MAX;
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+
+/* Returns aggregate ops/sec of all threads */
+static double bench_threadsRun(unsigned int nthreads, int mixed, int disjoint)
+{
+	uint64_t sliceSize = BENCH_SRC_MEM_SIZE / BENCH_MAX_THREADS;
+	double start, end;
+	unsigned int i;
+
+	sharedCache = cache_init(BENCH_SRC_MEM_SIZE, LIBCACHE_LINE_SIZE, LIBCACHE_LINES_CNT, &ops);
+	TEST_ASSERT_NOT_NULL(sharedCache);
+
+	for (i = 0; i < nthreads; i++) {
+		threads[i].idx = i;
+		/* every other thread is a writer in the mixed workload */
+		threads[i].write = mixed && (i % 2 != 0);
+		threads[i].rangeStart = disjoint ? i * sliceSize : 0;
+		/* overlapping threads access the same range of the size of a disjoint slice */
+		threads[i].rangeSize = sliceSize;
+		threads[i].seed = 2463534242u + i;
+		threads[i].blocked = 0;
+		threads[i].ready = 0;
+	}
+	threadsCnt = nthreads;
+
+	start = bench_now();
+
+	for (i = 0; i < nthreads; i++) {
+		TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i].tid, NULL, bench_thread, &threads[i]));
+	}
+
+	for (i = 0; i < nthreads; i++) {
+		TEST_ASSERT_EQUAL_INT(0, pthread_join(threads[i].tid, NULL));
+	}
+
+	end = bench_now();
+	threadsCnt = 0;
+
+	TEST_ASSERT_EQUAL_INT(EOK, cache_deinit(sharedCache));
+	sharedCache = NULL;
+
+	return nthreads * BENCH_THREAD_OPS / (end - start);
+}
+
+
+static int bench_latencyCmp(const void *a, const void *b)
+{
+	uint32_t la = *(const uint32_t *)a, lb = *(const uint32_t *)b;
+
+	return (la > lb) - (la < lb);
+}
+
+
+/* Reports latency percentiles and the time blocked on the contended mutexes of the last run */
+static void bench_threadsReport(const char *name, unsigned int nthreads)
+{
+	unsigned int n = nthreads * BENCH_THREAD_OPS, i;
+	double mean = 0.0, blocked = 0.0;
+
+	for (i = 0; i < nthreads; i++) {
+		memcpy(&latencies[i * BENCH_THREAD_OPS], threads[i].latency, sizeof(threads[i].latency));
+		blocked += threads[i].blocked;
+	}
+
+	qsort(latencies, n, sizeof(latencies[0]), bench_latencyCmp);
+	TEST_ASSERT_NOT_EQUAL_MESSAGE(UINT32_MAX, latencies[n - 1], "Cache operation failed");
+
+	for (i = 0; i < n; i++) {
+		mean += latencies[i];
+	}
+	mean /= n;
+	blocked /= n;
+
+	printf("METRIC name=%s.lat_p50 value=%u unit=ns better=lower\n", name, (unsigned int)latencies[n / 2]);
+	printf("METRIC name=%s.lat_p99 value=%u unit=ns better=lower\n", name,
+		(unsigned int)latencies[(99 * n + 99) / 100 - 1]);
+	printf("METRIC name=%s.blocked_per_op value=%.0f unit=ns better=lower\n", name, blocked);
+	printf("METRIC name=%s.blocked_ratio value=%.4f better=lower\n", name, blocked / mean);
+}
+
+
+TEST_GROUP(libcache_bench);
+
+
+TEST_SETUP(libcache_bench)
+{
+	ops.readCb = bench_readCb;
+	ops.writeCb = bench_writeCb;
+	ops.ctx = NULL;
+
+	srcMemBuf = malloc(BENCH_SRC_MEM_SIZE);
+	TEST_ASSERT_NOT_NULL(srcMemBuf);
+	memset(srcMemBuf, 0x5a, BENCH_SRC_MEM_SIZE);
+}
+
+
+TEST_TEAR_DOWN(libcache_bench)
+{
+	free(srcMemBuf);
+	srcMemBuf = NULL;
+}
+
+
+/*
+ * Associativity is fixed when libcache is built, sweeping the number of lines
+ * changes the number of sets (and the cache size) at a constant number of ways.
+ */
+BENCH_TEST(libcache_bench, patterns)
+{
+	static const size_t lineSizes[] = { 32, 64, 256 };
+	static const size_t linesCnts[] = { 16, 64, 256 };
+	unsigned int i, j;
+	int pattern, write;
+
+	zipfCdf = malloc(BENCH_BLOCKS * sizeof(zipfCdf[0]));
+	TEST_ASSERT_NOT_NULL(zipfCdf);
+	bench_zipfInit();
+
+	for (write = 0; write <= 1; write++) {
+		for (pattern = 0; pattern < pattern_count; pattern++) {
+			for (i = 0; i < sizeof(lineSizes) / sizeof(lineSizes[0]); i++) {
+				for (j = 0; j < sizeof(linesCnts) / sizeof(linesCnts[0]); j++) {
+					bench_cache(lineSizes[i], linesCnts[j], pattern, write);
+				}
+			}
+		}
+	}
+
+	free(zipfCdf);
+	zipfCdf = NULL;
+}
+
+
+/* Readers (and writers in the mixed workload) doing random accesses to overlapping or disjoint ranges */
+BENCH_TEST(libcache_bench, threads)
+{
+	unsigned int nthreads;
+	int mixed, disjoint;
+	char name[48];
+
+	for (mixed = 0; mixed <= 1; mixed++) {
+		for (nthreads = 1; nthreads <= BENCH_MAX_THREADS; nthreads *= 2) {
+			for (disjoint = 0; disjoint <= 1; disjoint++) {
+				snprintf(name, sizeof(name), "threads%u.%s.%s",
+					nthreads, mixed ? "mixed" : "read", disjoint ? "disjoint" : "overlap");
+
+				BENCHMARK(name, "ops/s", 1)
+				{
+					UnityBenchmarkSample(bench_threadsRun(nthreads, mixed, disjoint));
+				}
+
+				bench_threadsReport(name, nthreads);
+			}
+		}
+	}
+}
+
+
+TEST_GROUP_RUNNER(libcache_bench)
+{
+	RUN_TEST_CASE(libcache_bench, patterns);
+	RUN_TEST_CASE(libcache_bench, threads);
+}
+
+
+void runner(void)
+{
+	RUN_TEST_GROUP(libcache_bench);
+}
+
+
+int main(int argc, char *argv[])
+{
+	return (UnityMain(argc, (const char **)argv, runner) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -17,9 +17,16 @@
 #define _LIBCACHE_UTILS_H_
 
 
+#include <errno.h>
 #include <cache.h>
 
 
+/* make compilable against glibc (trace replay and benchmark are built for host) */
+#ifndef EOK
+#define EOK 0
+#endif
+
+
 #define LIBCACHE_SRC_MEM_SIZE 0x2800ULL /* Imitates the maximum capacity of cached source memory (in bytes) */
 #define LIBCACHE_LINES_CNT    32        /* Number of cache lines */
 #define LIBCACHE_LINE_SIZE    64        /* Size of a single cache line (in bytes) */
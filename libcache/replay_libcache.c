@@ -0,0 +1,368 @@
+/*
+ * Phoenix-RTOS
+ *
+ * phoenix-rtos-tests
+ *
+ * Libcache trace replay
+ *
+ * Replays recorded block accesses against libcache using write-through
+ * and write-back policies, reports hit ratio, written back volume and
+ * device time simulated from the number and size of the cache callbacks.
+ *
+ * Trace formats:
+ *  - CSV: one access per line "<op>,<offset>,<size>" where op is 'r' or 'w',
+ *    empty lines and lines starting with '#' are skipped,
+ *  - binary: "LCTRACE1" magic followed by 16-byte little-endian records:
+ *    uint8_t op ('r'/'w'), uint8_t pad[3], uint32_t size, uint64_t offset.
+ *
+ * Copyright 2025 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include "libcache_utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+#define REPLAY_MAGIC      "LCTRACE1"
+#define REPLAY_MAGIC_LEN  8
+#define REPLAY_REC_SIZE   16
+#define REPLAY_MAX_ACCESS (64 * 1024) /* Maximal size of a single access */
+
+
+typedef struct {
+	uint64_t offset;
+	uint32_t size;
+	char op;
+} replay_access_t;
+
+
+static struct {
+	replay_access_t *accesses;
+	size_t count;
+	size_t capacity;
+	uint64_t srcMemSize;
+} trace;
+
+
+static struct {
+	/* simulated device costs in ns */
+	unsigned long readCost;
+	unsigned long writeCost;
+	unsigned long byteCost;
+
+	unsigned long readCalls;
+	unsigned long writeCalls;
+	unsigned long long readBytes;
+	unsigned long long writeBytes;
+} device;
+
+
+static ssize_t replay_readCb(uint64_t offset, void *buffer, size_t count, cache_devCtx_t *ctx)
+{
+	device.readCalls++;
+	device.readBytes += count;
+
+	return test_readCb(offset, buffer, count, ctx);
+}
+
+
+static ssize_t replay_writeCb(uint64_t offset, const void *buffer, size_t count, cache_devCtx_t *ctx)
+{
+	device.writeCalls++;
+	device.writeBytes += count;
+
+	return test_writeCb(offset, buffer, count, ctx);
+}
+
+
+static int replay_add(char op, uint64_t offset, uint32_t size)
+{
+	replay_access_t *accesses;
+
+	if (((op != 'r') && (op != 'w')) || (size == 0) || (size > REPLAY_MAX_ACCESS)) {
+		return -EINVAL;
+	}
+
+	if (trace.count == trace.capacity) {
+		trace.capacity = (trace.capacity == 0) ? 1024 : 2 * trace.capacity;
+		accesses = realloc(trace.accesses, trace.capacity * sizeof(trace.accesses[0]));
+		if (accesses == NULL) {
+			return -ENOMEM;
+		}
+		trace.accesses = accesses;
+	}
+
+	trace.accesses[trace.count++] = (replay_access_t) { .offset = offset, .size = size, .op = op };
+	if (offset + size > trace.srcMemSize) {
+		trace.srcMemSize = offset + size;
+	}
+
+	return 0;
+}
+
+
+static uint64_t replay_le(const uint8_t *buf, unsigned int len)
+{
+	uint64_t val = 0;
+
+	while (len-- > 0) {
+		val = (val << 8) | buf[len];
+	}
+
+	return val;
+}
+
+
+static int replay_loadBinary(FILE *file)
+{
+	uint8_t rec[REPLAY_REC_SIZE];
+	int ret;
+
+	while (fread(rec, sizeof(rec), 1, file) == 1) {
+		ret = replay_add((char)rec[0], replay_le(rec + 8, 8), (uint32_t)replay_le(rec + 4, 4));
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	return ferror(file) ? -EIO : 0;
+}
+
+
+static int replay_loadCsv(FILE *file)
+{
+	char line[128], op;
+	unsigned long long offset;
+	unsigned long size;
+	unsigned int lineno = 0;
+
+	while (fgets(line, sizeof(line), file) != NULL) {
+		lineno++;
+		if ((line[0] == '#') || (line[0] == '\n') || (line[0] == '\r')) {
+			continue;
+		}
+
+		if ((sscanf(line, " %c,%llu,%lu", &op, &offset, &size) != 3) || (replay_add(op, offset, size) < 0)) {
+			fprintf(stderr, "Malformed trace line %u: %s", lineno, line);
+			return -EINVAL;
+		}
+	}
+
+	return ferror(file) ? -EIO : 0;
+}
+
+
+static int replay_load(const char *path)
+{
+	char magic[REPLAY_MAGIC_LEN];
+	FILE *file;
+	int ret;
+
+	file = fopen(path, "rb");
+	if (file == NULL) {
+		fprintf(stderr, "Unable to open %s\n", path);
+		return -errno;
+	}
+
+	if ((fread(magic, sizeof(magic), 1, file) == 1) && (memcmp(magic, REPLAY_MAGIC, REPLAY_MAGIC_LEN) == 0)) {
+		ret = replay_loadBinary(file);
+	}
+	else {
+		rewind(file);
+		ret = replay_loadCsv(file);
+	}
+
+	fclose(file);
+
+	return ret;
+}
+
+
+/* Number of cache lines touched by all accesses of the trace */
+static unsigned long long replay_linesTouched(size_t lineSize)
+{
+	unsigned long long lines = 0;
+	uint64_t first, last;
+	size_t i;
+
+	for (i = 0; i < trace.count; i++) {
+		first = trace.accesses[i].offset / lineSize;
+		last = (trace.accesses[i].offset + trace.accesses[i].size - 1) / lineSize;
+		lines += last - first + 1;
+	}
+
+	return lines;
+}
+
+
+static int replay_run(const char *imgPath, size_t lineSize, size_t linesCnt, int policy)
+{
+	static uint8_t buffer[REPLAY_MAX_ACCESS];
+	cache_ops_t ops = { .readCb = replay_readCb, .writeCb = replay_writeCb, .ctx = NULL };
+	test_write_args_t wargs = { .buffer = buffer, .policy = policy };
+	test_read_args_t rargs = { .buffer = buffer };
+	const char *name = (policy == LIBCACHE_WRITE_BACK) ? "wb" : "wt";
+	unsigned long long lines = replay_linesTouched(lineSize);
+	double deviceTime;
+	cachectx_t *cache;
+	size_t i;
+
+	/* backing store is a zeroed image of the traced device, only the accessed range is needed */
+	srcMem = open(imgPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if ((srcMem < 0) || (ftruncate(srcMem, (off_t)trace.srcMemSize) < 0)) {
+		fprintf(stderr, "Unable to create device image %s\n", imgPath);
+		return -1;
+	}
+
+	cache = cache_init(trace.srcMemSize, lineSize, linesCnt, &ops);
+	if (cache == NULL) {
+		fprintf(stderr, "cache_init() failed, lines count has to be a multiple of the number of ways\n");
+		close(srcMem);
+		return -1;
+	}
+
+	device.readCalls = 0;
+	device.writeCalls = 0;
+	device.readBytes = 0;
+	device.writeBytes = 0;
+
+	wargs.cache = cache;
+	rargs.cache = cache;
+	for (i = 0; i < trace.count; i++) {
+		if (trace.accesses[i].op == 'w') {
+			wargs.addr = trace.accesses[i].offset;
+			wargs.count = trace.accesses[i].size;
+			test_cache_write(&wargs);
+			if (wargs.actualCount != (ssize_t)wargs.count) {
+				break;
+			}
+		}
+		else {
+			rargs.addr = trace.accesses[i].offset;
+			rargs.count = trace.accesses[i].size;
+			test_cache_read(&rargs);
+			if (rargs.actualCount != (ssize_t)rargs.count) {
+				break;
+			}
+		}
+	}
+
+	/* dirty lines left in the cache would be written back eventually, include them */
+	cache_flush(cache, 0, trace.srcMemSize);
+	cache_deinit(cache);
+	close(srcMem);
+
+	if (i != trace.count) {
+		fprintf(stderr, "Cache operation failed on access %zu\n", i);
+		return -1;
+	}
+
+	deviceTime = (double)device.readCalls * device.readCost + (double)device.writeCalls * device.writeCost +
+		(double)(device.readBytes + device.writeBytes) * device.byteCost;
+
+	printf("%s: %zu accesses, %lu line fills, %lu writes (%llu B), device time %.3f s\n",
+		name, trace.count, device.readCalls, device.writeCalls, device.writeBytes, deviceTime / 1e9);
+	printf("METRIC name=%s.hit_ratio value=%.4f better=higher\n", name, 1.0 - (double)device.readCalls / lines);
+	printf("METRIC name=%s.writeback_bytes value=%llu unit=B better=lower\n", name, device.writeBytes);
+	printf("METRIC name=%s.write_callbacks value=%lu better=lower\n", name, device.writeCalls);
+	printf("METRIC name=%s.device_time value=%.6f unit=s better=lower\n", name, deviceTime / 1e9);
+
+	return 0;
+}
+
+
+static void usage(const char *progname)
+{
+	printf("Usage: %s [options] TRACE\n", progname);
+	printf("  -l SIZE   cache line size in bytes (default: %u)\n", LIBCACHE_LINE_SIZE);
+	printf("  -n COUNT  number of cache lines (default: %u)\n", LIBCACHE_LINES_CNT);
+	printf("  -p POLICY wt, wb or both (default: both)\n");
+	printf("  -r NS     simulated device read time per callback (default: %lu)\n", device.readCost);
+	printf("  -w NS     simulated device write time per callback (default: %lu)\n", device.writeCost);
+	printf("  -b NS     simulated device transfer time per byte (default: %lu)\n", device.byteCost);
+	printf("  -i FILE   device image used as the backing store (default: libcache_replay.img)\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+	const char *imgPath = "libcache_replay.img", *policy = "both";
+	size_t lineSize = LIBCACHE_LINE_SIZE, linesCnt = LIBCACHE_LINES_CNT;
+	int c, ret = 0;
+
+	/* defaults of a NOR flash: cheap reads, expensive programming */
+	device.readCost = 10000;
+	device.writeCost = 500000;
+	device.byteCost = 20;
+
+	while ((c = getopt(argc, argv, "l:n:p:r:w:b:i:h")) != -1) {
+		switch (c) {
+			case 'l':
+				lineSize = strtoul(optarg, NULL, 0);
+				break;
+			case 'n':
+				linesCnt = strtoul(optarg, NULL, 0);
+				break;
+			case 'p':
+				policy = optarg;
+				break;
+			case 'r':
+				device.readCost = strtoul(optarg, NULL, 0);
+				break;
+			case 'w':
+				device.writeCost = strtoul(optarg, NULL, 0);
+				break;
+			case 'b':
+				device.byteCost = strtoul(optarg, NULL, 0);
+				break;
+			case 'i':
+				imgPath = optarg;
+				break;
+			case 'h':
+			default:
+				usage(argv[0]);
+				return (c == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+
+	if ((optind != argc - 1) || (lineSize == 0) ||
+			((strcmp(policy, "wt") != 0) && (strcmp(policy, "wb") != 0) && (strcmp(policy, "both") != 0))) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (replay_load(argv[optind]) < 0) {
+		fprintf(stderr, "Unable to load trace %s\n", argv[optind]);
+		return EXIT_FAILURE;
+	}
+
+	if (trace.count == 0) {
+		fprintf(stderr, "Trace %s is empty\n", argv[optind]);
+		return EXIT_FAILURE;
+	}
+
+	printf("trace: %zu accesses, device size %llu B, line size %zu B, %zu lines\n",
+		trace.count, (unsigned long long)trace.srcMemSize, lineSize, linesCnt);
+
+	if ((ret == 0) && (strcmp(policy, "wb") != 0)) {
+		ret = replay_run(imgPath, lineSize, linesCnt, LIBCACHE_WRITE_THROUGH);
+	}
+	if ((ret == 0) && (strcmp(policy, "wt") != 0)) {
+		ret = replay_run(imgPath, lineSize, linesCnt, LIBCACHE_WRITE_BACK);
+	}
+
+	unlink(imgPath);
+	free(trace.accesses);
+
+	return (ret == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,344 @@
+/*
+ * Phoenix-RTOS
+ *
+ * phoenix-rtos-test
+ *
+ * Heap fragmentation and footprint of long running allocation patterns
+ *
+ * Workloads replay allocation lifetimes of a server: request buffers freed
+ * after a few ticks, long-lived cache entries replaced at random and bursts
+ * of temporary objects, a few of which survive for long. Heap footprint
+ * (memory the allocator took from the system with sbrk/mmap) is sampled
+ * against the bytes in use, fragmentation ratio is footprint / bytes in use.
+ *
+ * Copyright 2025 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "unity_fixture.h"
+
+
+#define REPLAY_TICKS      2000
+#define REPLAY_SAMPLE     100  /* Footprint sampling period in ticks */
+#define REPLAY_MAX_OBJS   1024 /* Max live objects of all kinds */
+#define REPLAY_PAGE_SIZE  4096
+
+#define REQ_MAX_NEW       4    /* Max requests started per tick */
+#define REQ_MAX_LIFETIME  8    /* in ticks */
+#define CACHE_ENTRIES     128
+#define BURST_PERIOD      16   /* in ticks */
+#define BURST_OBJS        256
+#define BURST_SURVIVE_PCT 2    /* Burst objects living for BURST_SURVIVE_MIN..2*BURST_SURVIVE_MIN ticks */
+#define BURST_SURVIVE_MIN 200
+
+#define WORKLOAD_REQUESTS (1 << 0)
+#define WORKLOAD_CACHE    (1 << 1)
+#define WORKLOAD_BURSTS   (1 << 2)
+
+
+typedef struct {
+	char *ptr;
+	size_t size;
+	unsigned int expires; /* Tick of the release, UINT32_MAX for cache entries */
+} replay_obj_t;
+
+
+static struct {
+	replay_obj_t objs[REPLAY_MAX_OBJS];
+	unsigned int freeIdx[REPLAY_MAX_OBJS]; /* Stack of free object slots */
+	unsigned int nfree;
+	unsigned int cache[CACHE_ENTRIES]; /* Object slots of the cache entries */
+	unsigned int ncache;
+	unsigned int seed;
+
+	size_t live;         /* Bytes in use by the workload */
+	unsigned long failed; /* Failed allocations */
+
+	size_t mapped;   /* Anonymous memory mapped with mmap (non-glibc libc) */
+	size_t unmapped; /* Memory unmapped with munmap (non-glibc libc) */
+} common;
+
+
+/*
+ * libc allocators other than glibc take the heap with mmap only. Test is linked with
+ * --wrap=mmap --wrap=munmap, so calls from the statically linked libc are counted.
+ */
+void *__real_mmap(void *addr, size_t len, int prot, int flags, int fd, off_t offs);
+
+
+int __real_munmap(void *addr, size_t len);
+
+
+void *__wrap_mmap(void *addr, size_t len, int prot, int flags, int fd, off_t offs)
+{
+	void *ptr = __real_mmap(addr, len, prot, flags, fd, offs);
+
+	if ((ptr != MAP_FAILED) && ((flags & MAP_ANONYMOUS) != 0)) {
+		common.mapped += (len + REPLAY_PAGE_SIZE - 1) & ~(size_t)(REPLAY_PAGE_SIZE - 1);
+	}
+
+	return ptr;
+}
+
+
+int __wrap_munmap(void *addr, size_t len)
+{
+	int ret = __real_munmap(addr, len);
+
+	if (ret == 0) {
+		common.unmapped += (len + REPLAY_PAGE_SIZE - 1) & ~(size_t)(REPLAY_PAGE_SIZE - 1);
+	}
+
+	return ret;
+}
+
+
+/* Heap footprint, memory taken from the system with sbrk and mmap */
+static size_t replay_footprint(size_t *brk, size_t *mmapped)
+{
+#ifdef __GLIBC__
+	struct mallinfo2 mi = mallinfo2();
+
+	*brk = mi.arena;
+	*mmapped = mi.hblkhd;
+#else
+	*brk = 0;
+	*mmapped = common.mapped - common.unmapped;
+#endif
+
+	return *brk + *mmapped;
+}
+
+
+static void replay_free(unsigned int idx)
+{
+	free(common.objs[idx].ptr);
+	common.live -= common.objs[idx].size;
+	common.objs[idx].ptr = NULL;
+	common.objs[idx].size = 0;
+	common.freeIdx[common.nfree++] = idx;
+}
+
+
+/* Returns object slot or -1 if the allocation failed */
+static int replay_alloc(size_t min, size_t max, unsigned int expires)
+{
+	size_t size = min + rand_r(&common.seed) % (max - min + 1U);
+	unsigned int idx;
+	char *ptr;
+
+	TEST_ASSERT_NOT_EQUAL_MESSAGE(0, common.nfree, "too many live objects");
+
+	if ((ptr = malloc(size)) == NULL) {
+		common.failed++;
+		return -1;
+	}
+	ptr[0] = ptr[size - 1] = 0x5a;
+
+	idx = common.freeIdx[--common.nfree];
+	common.objs[idx].ptr = ptr;
+	common.objs[idx].size = size;
+	common.objs[idx].expires = expires;
+	common.live += size;
+
+	return (int)idx;
+}
+
+
+/* Request header and body, both released when the request is done */
+static void replay_requests(unsigned int tick)
+{
+	unsigned int i, n = rand_r(&common.seed) % (REQ_MAX_NEW + 1U), done;
+
+	for (i = 0; i < n; i++) {
+		done = tick + 1U + rand_r(&common.seed) % REQ_MAX_LIFETIME;
+		(void)replay_alloc(64, 256, done);
+		(void)replay_alloc(256, 2048, done);
+	}
+}
+
+
+/* Cache fills up and then a random entry is replaced from time to time */
+static void replay_cache(void)
+{
+	unsigned int k;
+	int idx;
+
+	if (common.ncache < CACHE_ENTRIES) {
+		if ((idx = replay_alloc(32, 512, UINT32_MAX)) >= 0) {
+			common.cache[common.ncache++] = idx;
+		}
+		return;
+	}
+
+	if ((rand_r(&common.seed) % 4U) == 0U) {
+		k = rand_r(&common.seed) % CACHE_ENTRIES;
+		replay_free(common.cache[k]);
+		if ((idx = replay_alloc(32, 512, UINT32_MAX)) >= 0) {
+			common.cache[k] = idx;
+		}
+		else {
+			common.cache[k] = common.cache[--common.ncache];
+		}
+	}
+}
+
+
+/* Temporary objects released in the next tick, a few survive and pin the memory they are in */
+static void replay_burst(unsigned int tick)
+{
+	unsigned int i, expires;
+
+	for (i = 0; i < BURST_OBJS; i++) {
+		expires = tick + 1U;
+		if ((rand_r(&common.seed) % 100U) < BURST_SURVIVE_PCT) {
+			expires += BURST_SURVIVE_MIN + rand_r(&common.seed) % BURST_SURVIVE_MIN;
+		}
+		(void)replay_alloc(16, 256, expires);
+	}
+}
+
+
+static void replay_run(const char *name, unsigned int workloads)
+{
+	size_t base, brk, mmapped, footprint, prev, peak, peakLive = 0, returned = 0;
+	double ratio, ratioSum = 0.0, ratioMax = 0.0;
+	unsigned int tick, i, nsamples = 0;
+
+	common.nfree = REPLAY_MAX_OBJS;
+	for (i = 0; i < REPLAY_MAX_OBJS; i++) {
+		common.freeIdx[i] = REPLAY_MAX_OBJS - 1U - i;
+		common.objs[i].ptr = NULL;
+	}
+	common.ncache = 0;
+	common.seed = 1;
+	common.live = 0;
+	common.failed = 0;
+
+	/* heap left by the previous tests is a part of the footprint, run a single test (-n) to isolate the workloads */
+	base = replay_footprint(&brk, &mmapped);
+	prev = base;
+	peak = base;
+
+	for (tick = 0; tick < REPLAY_TICKS; tick++) {
+		for (i = 0; i < REPLAY_MAX_OBJS; i++) {
+			if ((common.objs[i].ptr != NULL) && (common.objs[i].expires <= tick)) {
+				replay_free(i);
+			}
+		}
+
+		if ((workloads & WORKLOAD_REQUESTS) != 0) {
+			replay_requests(tick);
+		}
+		if ((workloads & WORKLOAD_CACHE) != 0) {
+			replay_cache();
+		}
+		if (((workloads & WORKLOAD_BURSTS) != 0) && ((tick % BURST_PERIOD) == 0U)) {
+			replay_burst(tick);
+		}
+
+		footprint = replay_footprint(&brk, &mmapped);
+		returned += (footprint < prev) ? prev - footprint : 0;
+		prev = footprint;
+		peak = (footprint > peak) ? footprint : peak;
+		peakLive = (common.live > peakLive) ? common.live : peakLive;
+
+		if (((tick % REPLAY_SAMPLE) == 0U) && (common.live != 0U)) {
+			ratio = (double)footprint / common.live;
+			ratioSum += ratio;
+			ratioMax = (ratio > ratioMax) ? ratio : ratioMax;
+			nsamples++;
+			(void)printf("%s: tick=%u live=%zu footprint=%zu brk=%zu mmap=%zu frag=%.2f\n",
+				name, tick, common.live, footprint, brk, mmapped, ratio);
+		}
+	}
+
+	for (i = 0; i < REPLAY_MAX_OBJS; i++) {
+		if (common.objs[i].ptr != NULL) {
+			replay_free(i);
+		}
+	}
+	footprint = replay_footprint(&brk, &mmapped);
+	returned += (footprint < prev) ? prev - footprint : 0;
+
+	(void)printf("METRIC name=%s.base_footprint value=%zu unit=B better=lower\n", name, base);
+	(void)printf("METRIC name=%s.peak_footprint value=%zu unit=B better=lower\n", name, peak);
+	(void)printf("METRIC name=%s.peak_live value=%zu unit=B better=lower\n", name, peakLive);
+	(void)printf("METRIC name=%s.frag_avg value=%.3f better=lower\n", name, (nsamples != 0U) ? ratioSum / nsamples : 0.0);
+	(void)printf("METRIC name=%s.frag_max value=%.3f better=lower\n", name, ratioMax);
+	(void)printf("METRIC name=%s.returned value=%zu unit=B better=higher\n", name, returned);
+	/* memory kept by the allocator after everything is freed */
+	(void)printf("METRIC name=%s.retained value=%zu unit=B better=lower\n", name, footprint);
+	(void)printf("METRIC name=%s.failed value=%lu better=lower\n", name, common.failed);
+}
+
+
+TEST_GROUP(heap_replay);
+
+
+TEST_SETUP(heap_replay)
+{
+}
+
+
+TEST_TEAR_DOWN(heap_replay)
+{
+}
+
+
+BENCH_TEST(heap_replay, requests)
+{
+	replay_run("requests", WORKLOAD_REQUESTS);
+}
+
+
+BENCH_TEST(heap_replay, cache)
+{
+	replay_run("cache", WORKLOAD_CACHE | WORKLOAD_REQUESTS);
+}
+
+
+BENCH_TEST(heap_replay, bursts)
+{
+	replay_run("bursts", WORKLOAD_BURSTS | WORKLOAD_REQUESTS);
+}
+
+
+BENCH_TEST(heap_replay, mixed)
+{
+	replay_run("mixed", WORKLOAD_REQUESTS | WORKLOAD_CACHE | WORKLOAD_BURSTS);
+}
+
+
+TEST_GROUP_RUNNER(heap_replay)
+{
+	RUN_TEST_CASE(heap_replay, requests);
+	RUN_TEST_CASE(heap_replay, cache);
+	RUN_TEST_CASE(heap_replay, bursts);
+	RUN_TEST_CASE(heap_replay, mixed);
+}
+
+
+void runner(void)
+{
+	RUN_TEST_GROUP(heap_replay);
+}
+
+
+int main(int argc, char *argv[])
+{
+	return (UnityMain(argc, (const char **)argv, runner) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,411 @@
+/*
+ * Phoenix-RTOS
+ *
+ * phoenix-rtos-test
+ *
+ * Multi-threaded malloc benchmarks
+ *
+ * Workloads in the style of larson, xmalloc-test and mimalloc-bench run on
+ * 1..BENCH_MAX_THREADS threads for every size class of test_malloc.
+ * Aggregate operations/s and scaling efficiency (throughput on N threads
+ * divided by N times the throughput on a single thread) are reported.
+ *
+ * Copyright 2025 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "unity_fixture.h"
+
+
+#define BENCH_MAX_THREADS 8
+#define BENCH_MAX_SLOTS   256       /* Max live allocations per thread */
+#define BENCH_HUGE_MAX    (1 << 20) /* Huge allocations limit, test_malloc uses 32MB, too much for many threads */
+#define BENCH_PAGE_SIZE   4096
+
+
+enum size_mode {
+	SZMODE_SMALL = 0,
+	SZMODE_MEDIUM,
+	SZMODE_BIG,
+	SZMODE_HUGE,
+	SZMODE_MIXED,
+	SZMODE_NUM_MODES,
+};
+
+
+static const char *const szmodes[SZMODE_NUM_MODES] = { "small", "medium", "big", "huge", "mixed" };
+
+
+/* Work of a single thread, scaled down for the larger size classes to bound the memory in use */
+static const struct {
+	unsigned int slots;  /* Live allocations */
+	unsigned int ops;    /* malloc/free pairs (alloc_free) */
+	unsigned int rounds; /* Batches passed to the other thread (cross_thread) */
+	unsigned int chains; /* Grown and freed buffers (realloc_chain) */
+} modeParams[SZMODE_NUM_MODES] = {
+	{ 256, 20000, 64, 2000 },
+	{ 256, 20000, 64, 2000 },
+	{ 64, 10000, 32, 500 },
+	{ 8, 2000, 16, 50 },
+	{ 32, 10000, 32, 200 },
+};
+
+
+typedef struct {
+	pthread_t tid;
+	unsigned int idx;
+	unsigned int seed;
+	int err;
+	unsigned long ops;
+	char *slots[BENCH_MAX_SLOTS];
+} bench_thread_t;
+
+
+static struct {
+	bench_thread_t *threads;
+	unsigned int nthreads;
+	enum size_mode szmode;
+
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	int started;
+	int stop;                /* Run aborted before the start */
+	unsigned int waiting;    /* Threads waiting on the barrier */
+	unsigned int generation; /* Barrier generation */
+} common = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+};
+
+
+static uint64_t bench_nowNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+static size_t bench_size(enum size_mode szmode, unsigned int *seed)
+{
+	switch (szmode) {
+	case SZMODE_SMALL:
+		return 1 + rand_r(seed) % 100;
+	case SZMODE_MEDIUM:
+		return 100 + rand_r(seed) % 400;
+	case SZMODE_BIG:
+		return 500 + rand_r(seed) % (10 * BENCH_PAGE_SIZE);
+	case SZMODE_HUGE:
+		return 500 + rand_r(seed) % BENCH_HUGE_MAX;
+	case SZMODE_MIXED:
+		return bench_size(rand_r(seed) % SZMODE_MIXED, seed);
+	default:
+		return 0;
+	}
+}
+
+
+/* Allocates and touches the first and the last byte of the block, no assertions outside of the test thread */
+static char *bench_alloc(bench_thread_t *t, size_t size)
+{
+	char *ptr = malloc(size);
+
+	if (ptr == NULL) {
+		t->err = -ENOMEM;
+		return NULL;
+	}
+
+	ptr[0] = (char)t->idx;
+	ptr[size - 1] = (char)t->idx;
+
+	return ptr;
+}
+
+
+/* Waits for the start of the run, returns non-zero if the thread should exit without doing any work */
+static int bench_start(void)
+{
+	int stop;
+
+	(void)pthread_mutex_lock(&common.lock);
+	while (common.started == 0) {
+		(void)pthread_cond_wait(&common.cond, &common.lock);
+	}
+	stop = common.stop;
+	(void)pthread_mutex_unlock(&common.lock);
+
+	return stop;
+}
+
+
+static void bench_barrier(void)
+{
+	unsigned int generation;
+
+	(void)pthread_mutex_lock(&common.lock);
+	generation = common.generation;
+	if (++common.waiting == common.nthreads) {
+		common.waiting = 0;
+		common.generation++;
+		(void)pthread_cond_broadcast(&common.cond);
+	}
+	else {
+		while (generation == common.generation) {
+			(void)pthread_cond_wait(&common.cond, &common.lock);
+		}
+	}
+	(void)pthread_mutex_unlock(&common.lock);
+}
+
+
+/* larson: every thread replaces random blocks of its own working set */
+static void *bench_allocFree(void *arg)
+{
+	bench_thread_t *t = arg;
+	unsigned int i, k, slots = modeParams[common.szmode].slots;
+
+	if (bench_start() != 0) {
+		return NULL;
+	}
+
+	for (i = 0; i < modeParams[common.szmode].ops; ++i) {
+		k = rand_r(&t->seed) % slots;
+		free(t->slots[k]);
+		t->slots[k] = bench_alloc(t, bench_size(common.szmode, &t->seed));
+	}
+	t->ops = 2UL * i;
+
+	return NULL;
+}
+
+
+/* xmalloc-test: blocks are allocated by one thread and freed by the next one */
+static void *bench_crossThread(void *arg)
+{
+	bench_thread_t *t = arg, *peer = &common.threads[(t->idx + 1U) % common.nthreads];
+	unsigned int r, k, slots = modeParams[common.szmode].slots;
+
+	if (bench_start() != 0) {
+		return NULL;
+	}
+
+	for (r = 0; r < modeParams[common.szmode].rounds; ++r) {
+		for (k = 0; k < slots; ++k) {
+			t->slots[k] = bench_alloc(t, bench_size(common.szmode, &t->seed));
+		}
+		bench_barrier();
+
+		for (k = 0; k < slots; ++k) {
+			free(peer->slots[k]);
+			peer->slots[k] = NULL;
+		}
+		bench_barrier();
+	}
+	t->ops = 2UL * r * slots;
+
+	return NULL;
+}
+
+
+/* Buffers grown by realloc in random steps, like strings or vectors, then shrunk and freed */
+static void *bench_reallocChain(void *arg)
+{
+	bench_thread_t *t = arg;
+	unsigned int c;
+	size_t size, max;
+	char *ptr, *buf;
+
+	if (bench_start() != 0) {
+		return NULL;
+	}
+
+	for (c = 0; c < modeParams[common.szmode].chains; ++c) {
+		max = bench_size(common.szmode, &t->seed);
+		buf = NULL;
+		size = 0;
+
+		while (size < max) {
+			size += 1 + rand_r(&t->seed) % (max / 8 + 1);
+			if ((ptr = realloc(buf, size)) == NULL) {
+				t->err = -ENOMEM;
+				break;
+			}
+			ptr[size - 1] = (char)t->idx;
+			buf = ptr;
+			t->ops++;
+		}
+
+		if ((ptr = realloc(buf, size / 2 + 1)) != NULL) {
+			buf = ptr;
+		}
+		free(buf);
+		t->ops += 2;
+	}
+
+	return NULL;
+}
+
+
+/* Releases threads waiting for the start and joins them, used when not all of them could be created */
+static void bench_abort(unsigned int nthreads)
+{
+	unsigned int i;
+
+	(void)pthread_mutex_lock(&common.lock);
+	common.stop = 1;
+	common.started = 1;
+	(void)pthread_cond_broadcast(&common.cond);
+	(void)pthread_mutex_unlock(&common.lock);
+
+	for (i = 0; i < nthreads; ++i) {
+		(void)pthread_join(common.threads[i].tid, NULL);
+	}
+}
+
+
+/* Returns aggregate throughput in operations/s */
+static double bench_run(void *(*fn)(void *), unsigned int nthreads)
+{
+	uint64_t start, end;
+	unsigned long total = 0;
+	unsigned int i, k;
+	int ret;
+
+	common.nthreads = nthreads;
+	common.started = 0;
+	common.stop = 0;
+	common.waiting = 0;
+
+	for (i = 0; i < nthreads; ++i) {
+		common.threads[i].idx = i;
+		common.threads[i].seed = i + 1U;
+		common.threads[i].err = 0;
+		common.threads[i].ops = 0;
+		ret = pthread_create(&common.threads[i].tid, NULL, fn, &common.threads[i]);
+		if (ret != 0) {
+			/* failed assertion doesn't return, threads created so far would be left waiting */
+			bench_abort(i);
+			TEST_ASSERT_EQUAL(0, ret);
+		}
+	}
+
+	(void)pthread_mutex_lock(&common.lock);
+	common.started = 1;
+	start = bench_nowNs();
+	(void)pthread_cond_broadcast(&common.cond);
+	(void)pthread_mutex_unlock(&common.lock);
+
+	for (i = 0; i < nthreads; ++i) {
+		TEST_ASSERT_EQUAL(0, pthread_join(common.threads[i].tid, NULL));
+	}
+	end = bench_nowNs();
+
+	for (i = 0; i < nthreads; ++i) {
+		for (k = 0; k < BENCH_MAX_SLOTS; ++k) {
+			free(common.threads[i].slots[k]);
+			common.threads[i].slots[k] = NULL;
+		}
+		TEST_ASSERT_EQUAL_MESSAGE(0, common.threads[i].err, "allocation failed");
+		total += common.threads[i].ops;
+	}
+
+	return total * 1e9 / (double)(end - start);
+}
+
+
+static void bench_sweep(const char *test, void *(*fn)(void *))
+{
+	double rate, base = 0.0;
+	unsigned int n;
+	int szmode;
+	char name[64];
+
+	for (szmode = SZMODE_SMALL; szmode < SZMODE_NUM_MODES; ++szmode) {
+		common.szmode = szmode;
+
+		for (n = 1; n <= BENCH_MAX_THREADS; n *= 2U) {
+			(void)snprintf(name, sizeof(name), "%s.%s.threads%u", test, szmodes[szmode], n);
+
+			BENCHMARK(name, "ops/s", 1)
+			{
+				UnityBenchmarkSample(bench_run(fn, n));
+			}
+
+			/* median of the measured runs, the same as the reported ops/s metric */
+			rate = UnityBenchmarkMedian();
+			if (n == 1U) {
+				base = rate;
+			}
+			/* 1.0 if throughput grows linearly with the number of threads */
+			(void)printf("METRIC name=%s.efficiency value=%.3f better=higher\n", name, rate / (n * base));
+		}
+	}
+}
+
+
+TEST_GROUP(malloc_bench);
+
+
+TEST_SETUP(malloc_bench)
+{
+	common.threads = calloc(BENCH_MAX_THREADS, sizeof(common.threads[0]));
+	TEST_ASSERT_NOT_NULL(common.threads);
+}
+
+
+TEST_TEAR_DOWN(malloc_bench)
+{
+	free(common.threads);
+	common.threads = NULL;
+}
+
+
+BENCH_TEST(malloc_bench, alloc_free)
+{
+	bench_sweep("alloc_free", bench_allocFree);
+}
+
+
+BENCH_TEST(malloc_bench, cross_thread)
+{
+	bench_sweep("cross_thread", bench_crossThread);
+}
+
+
+BENCH_TEST(malloc_bench, realloc_chain)
+{
+	bench_sweep("realloc_chain", bench_reallocChain);
+}
+
+
+TEST_GROUP_RUNNER(malloc_bench)
+{
+	RUN_TEST_CASE(malloc_bench, alloc_free);
+	RUN_TEST_CASE(malloc_bench, cross_thread);
+	RUN_TEST_CASE(malloc_bench, realloc_chain);
+}
+
+
+void runner(void)
+{
+	RUN_TEST_GROUP(malloc_bench);
+}
+
+
+int main(int argc, char *argv[])
+{
+	return (UnityMain(argc, (const char **)argv, runner) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,359 @@
+/*
+ * Phoenix-RTOS
+ *
+ * phoenix-rtos-test
+ *
+ * mmap/munmap/mprotect benchmarks
+ *
+ * Latency of a single call is measured for anonymous and file-backed
+ * mappings of 1 page..BENCH_MAX_SIZE, in a fresh address space and in one
+ * fragmented by many small mappings with holes between them. Page fault
+ * throughput of the new mappings and cost of splitting and merging
+ * adjacent regions with mprotect and munmap are reported as well.
+ *
+ * Copyright 2025 Phoenix Systems
+ *
+ * This file is part of Phoenix-RTOS.
+ *
+ * %LICENSE%
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "unity_fixture.h"
+
+
+#define BENCH_MAX_SIZE     (64 << 20)
+#define BENCH_FILE_SIZE    (4 << 20)  /* Max file-backed mapping, bounded by the size of the target filesystems */
+#define BENCH_BATCH_BYTES  (16 << 20) /* Memory mapped at once by a single sample */
+#define BENCH_MAX_BATCH    32         /* Calls averaged by a single sample */
+#define BENCH_FRAG_REGIONS 1024       /* Single page mappings of the fragmented address space, every other is unmapped */
+#define BENCH_SPLIT_PAGES  16
+
+
+static const char *filename = "./mmap_bench_file";
+
+
+static struct {
+	size_t pageSize;
+	int fd;
+	void *regions[BENCH_MAX_BATCH];
+	void *frag[BENCH_FRAG_REGIONS];
+	unsigned int nfrag;
+} common;
+
+
+static uint64_t bench_nowNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+/* Number of mappings of the given size handled by a single sample */
+static unsigned int bench_batch(size_t size)
+{
+	size_t n = BENCH_BATCH_BYTES / size;
+
+	if (n == 0U) {
+		return 1;
+	}
+
+	return (n > BENCH_MAX_BATCH) ? BENCH_MAX_BATCH : (unsigned int)n;
+}
+
+
+static void *bench_map(size_t size, int fd)
+{
+	void *ptr;
+
+	if (fd < 0) {
+		ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	}
+	else {
+		ptr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	TEST_ASSERT_NOT_EQUAL(MAP_FAILED, ptr);
+
+	return ptr;
+}
+
+
+/* Faults in every page, anonymous pages are written and file pages are read */
+static unsigned int bench_touch(void *ptr, size_t size, int fd)
+{
+	volatile unsigned char *p = ptr;
+	unsigned int sum = 0;
+	size_t offs;
+
+	for (offs = 0; offs < size; offs += common.pageSize) {
+		if (fd < 0) {
+			p[offs] = 0x5a;
+		}
+		else {
+			sum += p[offs];
+		}
+	}
+
+	return sum;
+}
+
+
+static void bench_unmapAll(unsigned int n, size_t size)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		TEST_ASSERT_EQUAL(0, munmap(common.regions[i], size));
+	}
+}
+
+
+/* mmap and munmap latency, fault throughput and mprotect latency of a single size */
+static void bench_size(const char *prefix, size_t size, int fd)
+{
+	unsigned int i, n = bench_batch(size);
+	uint64_t start, sum;
+	char name[64];
+	int prot;
+
+	(void)snprintf(name, sizeof(name), "%s.mmap.size%zuK", prefix, size >> 10);
+	BENCHMARK(name, "ns", 0)
+	{
+		sum = 0;
+		for (i = 0; i < n; i++) {
+			start = bench_nowNs();
+			common.regions[i] = bench_map(size, fd);
+			sum += bench_nowNs() - start;
+		}
+		bench_unmapAll(n, size);
+		UnityBenchmarkSample((double)sum / n);
+	}
+
+	(void)snprintf(name, sizeof(name), "%s.fault.size%zuK", prefix, size >> 10);
+	BENCHMARK(name, "MB/s", 1)
+	{
+		sum = 0;
+		for (i = 0; i < n; i++) {
+			common.regions[i] = bench_map(size, fd);
+			start = bench_nowNs();
+			(void)bench_touch(common.regions[i], size, fd);
+			sum += bench_nowNs() - start;
+		}
+		bench_unmapAll(n, size);
+		UnityBenchmarkSample((double)n * size * 1e9 / (1 << 20) / (sum + 1U));
+	}
+
+	/* munmap of the populated mapping, freeing the pages is a part of the cost */
+	(void)snprintf(name, sizeof(name), "%s.munmap.size%zuK", prefix, size >> 10);
+	BENCHMARK(name, "ns", 0)
+	{
+		for (i = 0; i < n; i++) {
+			common.regions[i] = bench_map(size, fd);
+			(void)bench_touch(common.regions[i], size, fd);
+		}
+		sum = 0;
+		for (i = 0; i < n; i++) {
+			start = bench_nowNs();
+			TEST_ASSERT_EQUAL(0, munmap(common.regions[i], size));
+			sum += bench_nowNs() - start;
+		}
+		UnityBenchmarkSample((double)sum / n);
+	}
+
+	/* Protection of the whole populated mapping toggled between read-only and read-write */
+	(void)snprintf(name, sizeof(name), "%s.mprotect.size%zuK", prefix, size >> 10);
+	common.regions[0] = bench_map(size, fd);
+	(void)bench_touch(common.regions[0], size, fd);
+	prot = PROT_READ;
+	BENCHMARK(name, "ns", 0)
+	{
+		sum = 0;
+		for (i = 0; i < BENCH_MAX_BATCH; i++) {
+			prot = (prot == PROT_READ) ? (PROT_READ | PROT_WRITE) : PROT_READ;
+			start = bench_nowNs();
+			TEST_ASSERT_EQUAL(0, mprotect(common.regions[0], size, prot));
+			sum += bench_nowNs() - start;
+		}
+		UnityBenchmarkSample((double)sum / BENCH_MAX_BATCH);
+	}
+	TEST_ASSERT_EQUAL(0, munmap(common.regions[0], size));
+}
+
+
+static void bench_sweep(const char *prefix, size_t maxSize, int fd)
+{
+	size_t size;
+
+	for (size = common.pageSize; size <= maxSize; size *= 4U) {
+		bench_size(prefix, size, fd);
+	}
+}
+
+
+/* Leaves BENCH_FRAG_REGIONS / 2 single page mappings with single page holes between them */
+static void bench_fragment(void)
+{
+	unsigned int i;
+
+	for (common.nfrag = 0; common.nfrag < BENCH_FRAG_REGIONS; common.nfrag++) {
+		common.frag[common.nfrag] = mmap(NULL, common.pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		TEST_ASSERT_NOT_EQUAL(MAP_FAILED, common.frag[common.nfrag]);
+		*(volatile unsigned char *)common.frag[common.nfrag] = 0x5a;
+	}
+
+	for (i = 0; i < common.nfrag; i += 2U) {
+		TEST_ASSERT_EQUAL(0, munmap(common.frag[i], common.pageSize));
+		common.frag[i] = NULL;
+	}
+}
+
+
+TEST_GROUP(mmap_bench);
+
+
+TEST_SETUP(mmap_bench)
+{
+	common.pageSize = sysconf(_SC_PAGESIZE);
+	common.fd = -1;
+	common.nfrag = 0;
+}
+
+
+TEST_TEAR_DOWN(mmap_bench)
+{
+	unsigned int i;
+
+	for (i = 0; i < common.nfrag; i++) {
+		if (common.frag[i] != NULL) {
+			(void)munmap(common.frag[i], common.pageSize);
+		}
+	}
+	common.nfrag = 0;
+
+	if (common.fd >= 0) {
+		(void)close(common.fd);
+		(void)unlink(filename);
+	}
+}
+
+
+BENCH_TEST(mmap_bench, anon_fresh)
+{
+	bench_sweep("anon.fresh", BENCH_MAX_SIZE, -1);
+}
+
+
+BENCH_TEST(mmap_bench, anon_fragmented)
+{
+	bench_fragment();
+	bench_sweep("anon.fragmented", BENCH_MAX_SIZE, -1);
+}
+
+
+BENCH_TEST(mmap_bench, file)
+{
+	static unsigned char buf[4096];
+	size_t offs;
+
+	common.fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	TEST_ASSERT_NOT_EQUAL(-1, common.fd);
+
+	(void)memset(buf, 0x5a, sizeof(buf));
+	for (offs = 0; offs < BENCH_FILE_SIZE; offs += sizeof(buf)) {
+		TEST_ASSERT_EQUAL(sizeof(buf), write(common.fd, buf, sizeof(buf)));
+	}
+
+	bench_sweep("file.fresh", BENCH_FILE_SIZE, common.fd);
+	bench_fragment();
+	bench_sweep("file.fragmented", BENCH_FILE_SIZE, common.fd);
+}
+
+
+/* Protection change of a single page in the middle of a region splits it in three, restoring it merges them back */
+BENCH_TEST(mmap_bench, split_merge)
+{
+	size_t size = BENCH_SPLIT_PAGES * common.pageSize;
+	char *mid, *ptr = bench_map(size, -1);
+	uint64_t start, sum;
+	unsigned int i;
+
+	(void)bench_touch(ptr, size, -1);
+	mid = ptr + (BENCH_SPLIT_PAGES / 2) * common.pageSize;
+
+	BENCHMARK("split.mprotect", "ns", 0)
+	{
+		sum = 0;
+		for (i = 0; i < BENCH_MAX_BATCH; i++) {
+			start = bench_nowNs();
+			TEST_ASSERT_EQUAL(0, mprotect(mid, common.pageSize, PROT_READ));
+			sum += bench_nowNs() - start;
+			TEST_ASSERT_EQUAL(0, mprotect(mid, common.pageSize, PROT_READ | PROT_WRITE));
+		}
+		UnityBenchmarkSample((double)sum / BENCH_MAX_BATCH);
+	}
+
+	BENCHMARK("merge.mprotect", "ns", 0)
+	{
+		sum = 0;
+		for (i = 0; i < BENCH_MAX_BATCH; i++) {
+			TEST_ASSERT_EQUAL(0, mprotect(mid, common.pageSize, PROT_READ));
+			start = bench_nowNs();
+			TEST_ASSERT_EQUAL(0, mprotect(mid, common.pageSize, PROT_READ | PROT_WRITE));
+			sum += bench_nowNs() - start;
+		}
+		UnityBenchmarkSample((double)sum / BENCH_MAX_BATCH);
+	}
+
+	TEST_ASSERT_EQUAL(0, munmap(ptr, size));
+
+	/* munmap of a page in the middle leaves two regions */
+	BENCHMARK("split.munmap", "ns", 0)
+	{
+		sum = 0;
+		for (i = 0; i < BENCH_MAX_BATCH; i++) {
+			ptr = bench_map(size, -1);
+			(void)bench_touch(ptr, size, -1);
+			mid = ptr + (BENCH_SPLIT_PAGES / 2) * common.pageSize;
+
+			start = bench_nowNs();
+			TEST_ASSERT_EQUAL(0, munmap(mid, common.pageSize));
+			sum += bench_nowNs() - start;
+
+			TEST_ASSERT_EQUAL(0, munmap(ptr, mid - ptr));
+			TEST_ASSERT_EQUAL(0, munmap(mid + common.pageSize, size - (mid - ptr) - common.pageSize));
+		}
+		UnityBenchmarkSample((double)sum / BENCH_MAX_BATCH);
+	}
+}
+
+
+TEST_GROUP_RUNNER(mmap_bench)
+{
+	RUN_TEST_CASE(mmap_bench, anon_fresh);
+	RUN_TEST_CASE(mmap_bench, anon_fragmented);
+	RUN_TEST_CASE(mmap_bench, file);
+	RUN_TEST_CASE(mmap_bench, split_merge);
+}
+
+
+void runner(void)
+{
+	RUN_TEST_GROUP(mmap_bench);
+}
+
+
+int main(int argc, char *argv[])
+{
+	return (UnityMain(argc, (const char **)argv, runner) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -57,4 +57,12 @@ int file_devInfo(file_fsInfo_t *fsInfo);
 
 int file_init(const char *path);
 
+
+/* Measures mount time of the current filesystem content in ns, returns -ENOSYS if not supported */
+int file_mountTime(unsigned long long *ns);
+
+
+/* Prints flash operations counted since the last file_eraseAll() as METRIC lines, no-op if they aren't counted */
+void file_flashReport(const char *name);
+
 #endif
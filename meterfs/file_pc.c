@@ -9,23 +9,38 @@
  * %LICENSE%
  */
 
+#include <errno.h>
+#include <pthread.h>
 #include <string.h>
 #include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #include <host-flashsrv.h>
 #include <meterfs.h>
 #include <unity.h>
 
 #include "file.h"
+#include "flashsim.h"
 
 #define FLASHSIZE  (4 * 1024 * 1024)
 #define SECTORSIZE (4 * 1024)
 
+/* hostflashsrv isn't thread safe, requests are serialized like by the meterfs server on target */
+static struct {
+	pthread_mutex_t lock;
+	const char *path;
+} file_common = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+
 int file_lookup(const char *name)
 {
 	id_t id;
 	int err;
 
+	(void)pthread_mutex_lock(&file_common.lock);
 	err = hostflashsrv_lookup(name, &id);
+	(void)pthread_mutex_unlock(&file_common.lock);
 	if (err < 0) {
 		return err;
 	}
@@ -48,7 +63,9 @@ int file_open(const char *name)
 
 	id = ret;
 
+	(void)pthread_mutex_lock(&file_common.lock);
 	ret = hostflashsrv_open(&id);
+	(void)pthread_mutex_unlock(&file_common.lock);
 	if (ret < 0) {
 		return ret;
 	}
@@ -59,19 +76,43 @@ int file_open(const char *name)
 
 int file_close(id_t fid)
 {
-	return hostflashsrv_close(&fid);
+	int ret;
+
+	(void)pthread_mutex_lock(&file_common.lock);
+	ret = hostflashsrv_close(&fid);
+	(void)pthread_mutex_unlock(&file_common.lock);
+
+	return ret;
 }
 
 
 int file_write(id_t fid, const void *buff, size_t bufflen)
 {
-	return hostflashsrv_writeFile(&fid, buff, bufflen);
+	int ret;
+
+	(void)pthread_mutex_lock(&file_common.lock);
+	ret = hostflashsrv_writeFile(&fid, buff, bufflen);
+	if (ret > 0) {
+		flashsim_write(ret);
+	}
+	(void)pthread_mutex_unlock(&file_common.lock);
+
+	return ret;
 }
 
 
 int file_read(id_t fid, off_t offset, void *buff, size_t bufflen)
 {
-	return hostflashsrv_readFile(&fid, offset, buff, bufflen);
+	int ret;
+
+	(void)pthread_mutex_lock(&file_common.lock);
+	ret = hostflashsrv_readFile(&fid, offset, buff, bufflen);
+	if (ret > 0) {
+		flashsim_read(ret);
+	}
+	(void)pthread_mutex_unlock(&file_common.lock);
+
+	return ret;
 }
 
 
@@ -80,6 +121,7 @@ int file_allocate(const char *name, size_t sectors, size_t filesz, size_t record
 	meterfs_i_devctl_t iptr;
 	meterfs_o_devctl_t optr;
 	size_t len = 0;
+	int err;
 
 	iptr.type = meterfs_allocate;
 	len = strnlen(name, sizeof(iptr.allocate.name));
@@ -91,7 +133,11 @@ int file_allocate(const char *name, size_t sectors, size_t filesz, size_t record
 	iptr.allocate.filesz = filesz;
 	iptr.allocate.recordsz = recordsz;
 
-	return hostflashsrv_devctl(&iptr, &optr);
+	(void)pthread_mutex_lock(&file_common.lock);
+	err = hostflashsrv_devctl(&iptr, &optr);
+	(void)pthread_mutex_unlock(&file_common.lock);
+
+	return err;
 }
 
 
@@ -99,13 +145,18 @@ int file_resize(id_t fid, size_t filesz, size_t recordsz)
 {
 	meterfs_i_devctl_t iptr;
 	meterfs_o_devctl_t optr;
+	int err;
 
 	iptr.type = meterfs_resize;
 	iptr.resize.id = fid;
 	iptr.resize.filesz = filesz;
 	iptr.resize.recordsz = recordsz;
 
-	return hostflashsrv_devctl(&iptr, &optr);
+	(void)pthread_mutex_lock(&file_common.lock);
+	err = hostflashsrv_devctl(&iptr, &optr);
+	(void)pthread_mutex_unlock(&file_common.lock);
+
+	return err;
 }
 
 
@@ -113,11 +164,16 @@ int file_reset(id_t fid)
 {
 	meterfs_i_devctl_t iptr;
 	meterfs_o_devctl_t optr;
+	int err;
 
 	iptr.type = meterfs_reset;
 	iptr.id = fid;
 
-	return hostflashsrv_devctl(&iptr, &optr);
+	(void)pthread_mutex_lock(&file_common.lock);
+	err = hostflashsrv_devctl(&iptr, &optr);
+	(void)pthread_mutex_unlock(&file_common.lock);
+
+	return err;
 }
 
 
@@ -130,7 +186,9 @@ int file_getInfo(id_t fid, size_t *sectors, size_t *filesz, size_t *recordsz, si
 	iptr.type = meterfs_info;
 	iptr.id = fid;
 
+	(void)pthread_mutex_lock(&file_common.lock);
 	err = hostflashsrv_devctl(&iptr, &optr);
+	(void)pthread_mutex_unlock(&file_common.lock);
 	if (err < 0) {
 		return err;
 	}
@@ -159,10 +217,18 @@ int file_eraseAll(void)
 {
 	meterfs_i_devctl_t iptr;
 	meterfs_o_devctl_t optr;
+	int err;
 
 	iptr.type = meterfs_chiperase;
 
-	return hostflashsrv_devctl(&iptr, &optr);
+	(void)pthread_mutex_lock(&file_common.lock);
+	err = hostflashsrv_devctl(&iptr, &optr);
+	if (err == 0) {
+		flashsim_reset();
+	}
+	(void)pthread_mutex_unlock(&file_common.lock);
+
+	return err;
 }
 
 
@@ -174,7 +240,9 @@ int file_devInfo(file_fsInfo_t *fsInfo)
 
 	iptr.type = meterfs_fsInfo;
 
+	(void)pthread_mutex_lock(&file_common.lock);
 	err = hostflashsrv_devctl(&iptr, &optr);
+	(void)pthread_mutex_unlock(&file_common.lock);
 	if (err < 0) {
 		return err;
 	}
@@ -188,6 +256,14 @@ int file_devInfo(file_fsInfo_t *fsInfo)
 }
 
 
+void file_flashReport(const char *name)
+{
+	(void)pthread_mutex_lock(&file_common.lock);
+	flashsim_report(name);
+	(void)pthread_mutex_unlock(&file_common.lock);
+}
+
+
 int file_init(const char *path)
 {
 	size_t filesz = FLASHSIZE;
@@ -197,6 +273,59 @@ int file_init(const char *path)
 	err = hostflashsrv_init(&filesz, &sectorsz, path);
 	if (err < 0) {
 		(void)printf("hostflashsrv: init failed\n");
+		return err;
 	}
+
+	file_common.path = path;
+	flashsim_init(filesz, sectorsz);
+
+	return err;
+}
+
+
+int file_mountTime(unsigned long long *ns)
+{
+	size_t filesz = FLASHSIZE;
+	size_t sectorsz = SECTORSIZE;
+	struct timespec start, end;
+	unsigned long long elapsed;
+	int fds[2], status, err;
+	pid_t pid;
+
+	if (pipe(fds) < 0) {
+		return -errno;
+	}
+
+	/* mount in a child process, state of the already mounted filesystem is kept intact */
+	(void)fflush(stdout);
+	pid = fork();
+	if (pid < 0) {
+		err = -errno;
+		(void)close(fds[0]);
+		(void)close(fds[1]);
+		return err;
+	}
+
+	if (pid == 0) {
+		(void)close(fds[0]);
+		(void)clock_gettime(CLOCK_MONOTONIC, &start);
+		err = hostflashsrv_init(&filesz, &sectorsz, file_common.path);
+		(void)clock_gettime(CLOCK_MONOTONIC, &end);
+
+		elapsed = (end.tv_sec - start.tv_sec) * 1000000000ULL + end.tv_nsec - start.tv_nsec;
+		if ((err < 0) || (write(fds[1], &elapsed, sizeof(elapsed)) != sizeof(elapsed))) {
+			_exit(1);
+		}
+		_exit(0);
+	}
+
+	(void)close(fds[1]);
+	err = (read(fds[0], ns, sizeof(*ns)) == sizeof(*ns)) ? 0 : -EIO;
+	(void)close(fds[0]);
+
+	if ((waitpid(pid, &status, 0) < 0) || !WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
+		err = -EIO;
+	}
+
 	return err;
 }
@@ -9,6 +9,7 @@
  * %LICENSE%
  */
 
+#include <errno.h>
 #include <stdio.h>
 #include <sys/msg.h>
 #include <string.h>
@@ -283,3 +284,19 @@ int file_init(const char *path)
 	pathPrefix = path;
 	return lookup(path, NULL, &meterfs);
 }
+
+
+int file_mountTime(unsigned long long *ns)
+{
+	/* meterfs server mounts the filesystem only once, at its startup */
+	(void)ns;
+
+	return -ENOSYS;
+}
+
+
+void file_flashReport(const char *name)
+{
+	/* flash operations are done by the meterfs server, they can't be counted */
+	(void)name;
+}
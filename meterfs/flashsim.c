@@ -0,0 +1,273 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Meterfs host flash timing and accounting
+ *
+ * Reads, page programs and sector erases are counted at the host-flash driver,
+ * below meterfs, so they follow the real on-flash layout and the write pattern
+ * of meterfs. Every call is charged per page (or per sector for erases) it spans.
+ *
+ * METERFS_FLASHSIM parameters (defaults correspond to a typical SPI NOR flash):
+ *  - page:    program/read page size in bytes (256),
+ *  - program: page program time in us (700),
+ *  - read:    page read time in us (50),
+ *  - erase:   sector erase time in us (45000),
+ *  - delay:   if non-zero, charged times are also slept (0).
+ *
+ * Copyright 2025 Phoenix Systems
+ *
+ *
+ * %LICENSE%
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "flashsim.h"
+
+
+static struct {
+	size_t pagesz;
+	unsigned long programUs;
+	unsigned long readUs;
+	unsigned long eraseUs;
+	int delay;
+
+	size_t sectorsz;
+	size_t sectorcnt;
+	unsigned int *erases; /* Erase count of every sector since the last reset */
+
+	unsigned long long userWrites;
+	unsigned long long userWritten;
+	unsigned long long userReads;
+	unsigned long long programmed;
+	unsigned long long programPages;
+	unsigned long long readPages;
+	unsigned long long eraseCnt;
+	unsigned long long writeTime; /* Program and erase time, in us */
+	unsigned long long readTime;
+} flashsim = {
+	.pagesz = 256,
+	.programUs = 700,
+	.readUs = 50,
+	.eraseUs = 45000,
+};
+
+
+/* host-flash driver functions, the test is linked with --wrap on them */
+ssize_t __real_hostflash_read(size_t offs, void *buff, size_t bufflen);
+
+
+ssize_t __real_hostflash_write(size_t offs, const void *buff, size_t bufflen);
+
+
+int __real_hostflash_sectorErase(size_t offs);
+
+
+static void flashsim_charge(unsigned long long *total, unsigned long long us)
+{
+	struct timespec ts;
+
+	*total += us;
+
+	if ((flashsim.delay != 0) && (us != 0)) {
+		ts.tv_sec = us / 1000000;
+		ts.tv_nsec = (us % 1000000) * 1000;
+		(void)nanosleep(&ts, NULL);
+	}
+}
+
+
+static size_t flashsim_pages(size_t offs, size_t len)
+{
+	return ((offs + len - 1U) / flashsim.pagesz) - (offs / flashsim.pagesz) + 1U;
+}
+
+
+ssize_t __wrap_hostflash_read(size_t offs, void *buff, size_t bufflen)
+{
+	ssize_t ret = __real_hostflash_read(offs, buff, bufflen);
+	size_t pages;
+
+	if (ret > 0) {
+		pages = flashsim_pages(offs, (size_t)ret);
+		flashsim.readPages += pages;
+		flashsim_charge(&flashsim.readTime, (unsigned long long)pages * flashsim.readUs);
+	}
+
+	return ret;
+}
+
+
+ssize_t __wrap_hostflash_write(size_t offs, const void *buff, size_t bufflen)
+{
+	ssize_t ret = __real_hostflash_write(offs, buff, bufflen);
+	size_t pages;
+
+	if (ret > 0) {
+		pages = flashsim_pages(offs, (size_t)ret);
+		flashsim.programmed += (size_t)ret;
+		flashsim.programPages += pages;
+		flashsim_charge(&flashsim.writeTime, (unsigned long long)pages * flashsim.programUs);
+	}
+
+	return ret;
+}
+
+
+int __wrap_hostflash_sectorErase(size_t offs)
+{
+	int ret = __real_hostflash_sectorErase(offs);
+	size_t sector;
+
+	if (ret >= 0) {
+		if (flashsim.sectorsz != 0) {
+			sector = offs / flashsim.sectorsz;
+			if (sector < flashsim.sectorcnt) {
+				flashsim.erases[sector]++;
+			}
+		}
+		flashsim.eraseCnt++;
+		flashsim_charge(&flashsim.writeTime, flashsim.eraseUs);
+	}
+
+	return ret;
+}
+
+
+static void flashsim_configure(const char *cfg)
+{
+	char key[16];
+	unsigned long val;
+	int n;
+
+	while (*cfg != '\0') {
+		if (sscanf(cfg, "%15[a-z]=%lu%n", key, &val, &n) != 2) {
+			(void)printf("flashsim: malformed METERFS_FLASHSIM at \"%s\"\n", cfg);
+			return;
+		}
+
+		if ((strcmp(key, "page") == 0) && (val != 0)) {
+			flashsim.pagesz = val;
+		}
+		else if (strcmp(key, "program") == 0) {
+			flashsim.programUs = val;
+		}
+		else if (strcmp(key, "read") == 0) {
+			flashsim.readUs = val;
+		}
+		else if (strcmp(key, "erase") == 0) {
+			flashsim.eraseUs = val;
+		}
+		else if (strcmp(key, "delay") == 0) {
+			flashsim.delay = (val != 0);
+		}
+		else {
+			(void)printf("flashsim: unknown METERFS_FLASHSIM parameter \"%s\"\n", key);
+		}
+
+		cfg += n;
+		if (*cfg == ',') {
+			cfg++;
+		}
+	}
+}
+
+
+void flashsim_init(size_t flashsz, size_t sectorsz)
+{
+	const char *cfg = getenv("METERFS_FLASHSIM");
+
+	if ((flashsim.erases != NULL) || (sectorsz == 0)) {
+		return;
+	}
+
+	if (cfg != NULL) {
+		flashsim_configure(cfg);
+	}
+
+	flashsim.erases = calloc(flashsz / sectorsz, sizeof(*flashsim.erases));
+	if (flashsim.erases != NULL) {
+		flashsim.sectorsz = sectorsz;
+		flashsim.sectorcnt = flashsz / sectorsz;
+	}
+
+	flashsim_reset();
+}
+
+
+void flashsim_write(size_t len)
+{
+	flashsim.userWrites++;
+	flashsim.userWritten += len;
+}
+
+
+void flashsim_read(size_t len)
+{
+	(void)len;
+
+	flashsim.userReads++;
+}
+
+
+void flashsim_reset(void)
+{
+	if (flashsim.sectorcnt != 0) {
+		(void)memset(flashsim.erases, 0, flashsim.sectorcnt * sizeof(*flashsim.erases));
+	}
+
+	flashsim.userWrites = 0;
+	flashsim.userWritten = 0;
+	flashsim.userReads = 0;
+	flashsim.programmed = 0;
+	flashsim.programPages = 0;
+	flashsim.readPages = 0;
+	flashsim.eraseCnt = 0;
+	flashsim.writeTime = 0;
+	flashsim.readTime = 0;
+}
+
+
+void flashsim_report(const char *name)
+{
+	unsigned int maxErases = 0;
+	unsigned long long total = 0;
+	size_t i, erased = 0;
+
+	if (flashsim.userWrites != 0) {
+		(void)printf("METRIC name=%s.flash.write_amp value=%.3f better=lower\n", name,
+			(double)flashsim.programmed / flashsim.userWritten);
+		(void)printf("METRIC name=%s.flash.pages_per_write value=%.3f unit=pages better=lower\n", name,
+			(double)flashsim.programPages / flashsim.userWrites);
+		(void)printf("METRIC name=%s.flash.erases_per_mb value=%.3f unit=sectors better=lower\n", name,
+			(double)flashsim.eraseCnt * (1 << 20) / flashsim.userWritten);
+		(void)printf("METRIC name=%s.flash.time_per_write value=%.0f unit=us better=lower\n", name,
+			(double)flashsim.writeTime / flashsim.userWrites);
+	}
+
+	if (flashsim.userReads != 0) {
+		(void)printf("METRIC name=%s.flash.pages_per_read value=%.3f unit=pages better=lower\n", name,
+			(double)flashsim.readPages / flashsim.userReads);
+		(void)printf("METRIC name=%s.flash.time_per_read value=%.0f unit=us better=lower\n", name,
+			(double)flashsim.readTime / flashsim.userReads);
+	}
+
+	/* wear leveling, 1.0 if all erased sectors were erased the same number of times */
+	for (i = 0; i < flashsim.sectorcnt; ++i) {
+		if (flashsim.erases[i] != 0) {
+			erased++;
+			total += flashsim.erases[i];
+		}
+		if (flashsim.erases[i] > maxErases) {
+			maxErases = flashsim.erases[i];
+		}
+	}
+
+	if (erased != 0) {
+		(void)printf("METRIC name=%s.flash.erase_max_to_mean value=%.3f better=lower\n", name,
+			(double)maxErases * erased / total);
+	}
+}
@@ -0,0 +1,45 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Meterfs host flash timing and accounting
+ *
+ * Copyright 2025 Phoenix Systems
+ *
+ *
+ * %LICENSE%
+ */
+
+#ifndef FLASHSIM_H
+#define FLASHSIM_H
+
+#include <sys/types.h>
+
+
+/*
+ * Host flash stand-in is instant. Tests are linked with --wrap on the host-flash driver
+ * read, write and sector erase functions, so the flash operations issued by meterfs are
+ * counted in pages and sectors and charged with latencies of a real NOR flash.
+ * Parameters are taken from the METERFS_FLASHSIM environment variable, a comma
+ * separated list of key=value pairs (page, program, read, erase, delay), see flashsim.c.
+ */
+
+
+void flashsim_init(size_t flashsz, size_t sectorsz);
+
+
+/* Accounts a record written by the user, base of the write amplification */
+void flashsim_write(size_t len);
+
+
+/* Accounts a read of the user */
+void flashsim_read(size_t len);
+
+
+/* Clears statistics, chip erase is a test setup step and isn't accounted */
+void flashsim_reset(void);
+
+
+/* Prints statistics since the last reset as METRIC lines prefixed with name */
+void flashsim_report(const char *name);
+
+#endif
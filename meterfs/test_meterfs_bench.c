@@ -0,0 +1,255 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Meterfs write/read throughput benchmarks
+ *
+ * Every run allocates fresh files, fills them up (fill phase), keeps writing
+ * until each file has turned twice (steady phase, every write makes meterfs
+ * drop the oldest record and from time to time erase a sector) and reads all
+ * records back. Records/s and bytes/s are reported for all phases.
+ *
+ * Copyright 2025 Phoenix Systems
+ *
+ *
+ * %LICENSE%
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "common.h"
+
+
+#define BENCH_MAX_RECORDSZ 256
+#define BENCH_MAX_FILES    8
+#define BENCH_TURNS        2  /* Number of whole file rewrites in the steady phase */
+#define BENCH_ENTRY_MARGIN 32 /* Upper bound of meterfs metadata stored with each record */
+
+
+typedef struct {
+	size_t recordsz;
+	size_t records; /* File capacity in records */
+	size_t sectors;
+	unsigned int nfiles;
+} bench_config_t;
+
+
+typedef struct {
+	double fill;   /* Elapsed times of all phases in seconds */
+	double steady;
+	double read;
+} bench_times_t;
+
+
+static struct {
+	file_fsInfo_t fsInfo;
+	int fd[BENCH_MAX_FILES];
+	unsigned char buffTX[BENCH_MAX_RECORDSZ];
+	unsigned char buffRX[BENCH_MAX_RECORDSZ];
+} common;
+
+
+static double bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+
+/* Least number of sectors able to hold all records of the file with a spare sector for turning */
+static size_t bench_minSectors(size_t recordsz, size_t records)
+{
+	size_t bytes = records * (recordsz + BENCH_ENTRY_MARGIN);
+
+	return ((bytes + common.fsInfo.sectorsz - 1U) / common.fsInfo.sectorsz) + 1U;
+}
+
+
+/* Writes records to all files in a round-robin manner, returns elapsed time */
+static double bench_write(const bench_config_t *cfg, size_t records, size_t *seq)
+{
+	double start;
+	size_t i;
+	unsigned int f;
+
+	start = bench_now();
+
+	for (i = 0; i < records; ++i) {
+		for (f = 0; f < cfg->nfiles; ++f) {
+			(void)memcpy(common.buffTX, seq, sizeof(*seq));
+			(*seq)++;
+			TEST_ASSERT_EQUAL_INT(cfg->recordsz, file_write(common.fd[f], common.buffTX, cfg->recordsz));
+		}
+	}
+
+	return bench_now() - start;
+}
+
+
+static double bench_read(const bench_config_t *cfg)
+{
+	double start;
+	size_t i;
+	unsigned int f;
+
+	start = bench_now();
+
+	for (f = 0; f < cfg->nfiles; ++f) {
+		for (i = 0; i < cfg->records; ++i) {
+			TEST_ASSERT_EQUAL_INT(cfg->recordsz, file_read(common.fd[f], i * cfg->recordsz, common.buffRX, cfg->recordsz));
+		}
+	}
+
+	return bench_now() - start;
+}
+
+
+static void bench_run(const bench_config_t *cfg, bench_times_t *times)
+{
+	char fileName[16];
+	size_t seq = 0;
+	unsigned int f;
+
+	TEST_ASSERT_EQUAL(0, file_eraseAll());
+
+	for (f = 0; f < cfg->nfiles; ++f) {
+		(void)snprintf(fileName, sizeof(fileName), "bench%u", f);
+		common.fd[f] = common_preallocOpenFile(fileName, cfg->sectors, cfg->records * cfg->recordsz, cfg->recordsz);
+	}
+
+	times->fill = bench_write(cfg, cfg->records, &seq);
+	times->steady = bench_write(cfg, BENCH_TURNS * cfg->records, &seq);
+	times->read = bench_read(cfg);
+
+	for (f = 0; f < cfg->nfiles; ++f) {
+		TEST_ASSERT_EQUAL(0, file_close(common.fd[f]));
+	}
+}
+
+
+static void bench_config(size_t recordsz, size_t records, size_t extraSectors, unsigned int nfiles)
+{
+	bench_config_t cfg = { recordsz, records, bench_minSectors(recordsz, records) + extraSectors, nfiles };
+	bench_times_t times, sum = { 0 };
+	double recs, bytes;
+	unsigned int runs = 0;
+	char name[64], steadyName[80];
+
+	(void)snprintf(name, sizeof(name), "rec%zu.recs%zu.sect%zu.files%u", cfg.recordsz, cfg.records, cfg.sectors, cfg.nfiles);
+
+	/* one sector is reserved for the filesystem header */
+	if ((cfg.sectors * cfg.nfiles) > ((common.fsInfo.sz / common.fsInfo.sectorsz) - 1U)) {
+		(void)printf("%s: skipped, does not fit on the flash\n", name);
+		return;
+	}
+
+	(void)snprintf(steadyName, sizeof(steadyName), "%s.steady", name);
+	recs = (double)cfg.records * cfg.nfiles;
+	bytes = recs * cfg.recordsz;
+
+	BENCHMARK(steadyName, "rec/s", 1)
+	{
+		bench_run(&cfg, &times);
+		sum.fill += times.fill;
+		sum.steady += times.steady;
+		sum.read += times.read;
+		runs++;
+		UnityBenchmarkSample(BENCH_TURNS * recs / times.steady);
+	}
+
+	/* the other rates are reported as means over all runs, including the warmup */
+	(void)printf("METRIC name=%s.fill value=%.0f unit=rec/s better=higher\n", name, runs * recs / sum.fill);
+	(void)printf("METRIC name=%s.fill_bytes value=%.0f unit=B/s better=higher\n", name, runs * bytes / sum.fill);
+	(void)printf("METRIC name=%s.steady_bytes value=%.0f unit=B/s better=higher\n", name, runs * BENCH_TURNS * bytes / sum.steady);
+	(void)printf("METRIC name=%s.read value=%.0f unit=rec/s better=higher\n", name, runs * recs / sum.read);
+	(void)printf("METRIC name=%s.read_bytes value=%.0f unit=B/s better=higher\n", name, runs * bytes / sum.read);
+
+	/* flash operations of the last run, bench_run() starts with the chip erase */
+	file_flashReport(name);
+}
+
+
+TEST_GROUP(meterfs_bench);
+
+
+TEST_SETUP(meterfs_bench)
+{
+	TEST_ASSERT_EQUAL(0, file_devInfo(&common.fsInfo));
+	(void)memset(common.buffTX, 0x5a, sizeof(common.buffTX));
+}
+
+
+TEST_TEAR_DOWN(meterfs_bench)
+{
+	TEST_ASSERT_EQUAL(0, file_eraseAll());
+}
+
+
+/* Single open file, sweep of record size, file size and number of sectors */
+BENCH_TEST(meterfs_bench, record_file_sectors)
+{
+	static const size_t recordSizes[] = { 16, 64, 256 };
+	static const size_t fileRecords[] = { 64, 512 };
+	static const size_t extraSectors[] = { 0, 4 };
+	size_t r, n, s;
+
+	for (r = 0; r < sizeof(recordSizes) / sizeof(recordSizes[0]); ++r) {
+		for (n = 0; n < sizeof(fileRecords) / sizeof(fileRecords[0]); ++n) {
+			for (s = 0; s < sizeof(extraSectors) / sizeof(extraSectors[0]); ++s) {
+				bench_config(recordSizes[r], fileRecords[n], extraSectors[s], 1);
+			}
+		}
+	}
+}
+
+
+/* Writes interleaved between many open files */
+BENCH_TEST(meterfs_bench, open_files)
+{
+	static const size_t recordSizes[] = { 16, 256 };
+	static const unsigned int openFiles[] = { 2, 4, BENCH_MAX_FILES };
+	size_t r, f;
+
+	for (r = 0; r < sizeof(recordSizes) / sizeof(recordSizes[0]); ++r) {
+		for (f = 0; f < sizeof(openFiles) / sizeof(openFiles[0]); ++f) {
+			bench_config(recordSizes[r], 128, 0, openFiles[f]);
+		}
+	}
+}
+
+
+TEST_GROUP_RUNNER(meterfs_bench)
+{
+	RUN_TEST_CASE(meterfs_bench, record_file_sectors);
+	RUN_TEST_CASE(meterfs_bench, open_files);
+}
+
+
+void runner(void)
+{
+	RUN_TEST_GROUP(meterfs_bench);
+}
+
+
+int main(int argc, char *argv[])
+{
+	/* mount path may be followed by Unity options, e.g. -b to run the benchmarks */
+	if (argc < 2) {
+		(void)printf("Usage: %s /meterfs/mount/path [unity options]\n", argv[0]);
+		return 1;
+	}
+	if (file_init(argv[1]) != 0) {
+		(void)printf("Failed to initialize test\n");
+		return 1;
+	}
+	if (file_eraseAll() != 0) {
+		(void)printf("Failed to format meterfs partition\n");
+		return 1;
+	}
+
+	return (UnityMain(argc, (const char **)argv, runner) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,340 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Meterfs concurrent writers benchmarks
+ *
+ * Writer threads log records for a fixed time, either each to its own file
+ * or all to a single shared file. Aggregate throughput, write latency
+ * percentiles of every writer and Jain's fairness index of the numbers
+ * of records written by the writers are reported.
+ *
+ * Copyright 2025 Phoenix Systems
+ *
+ *
+ * %LICENSE%
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "common.h"
+
+
+#define BENCH_RECORDSZ    64
+#define BENCH_MAX_WRITERS 8
+#define BENCH_DURATION_MS 500
+#define BENCH_MAX_SAMPLES 4096 /* Latencies kept per writer, a uniform sample of all writes is kept */
+
+
+typedef struct {
+	pthread_t tid;
+	unsigned int idx;
+	int fd;
+	int err;
+	unsigned long ops;
+	uint32_t seed;
+	uint32_t latency[BENCH_MAX_SAMPLES]; /* in ns */
+} bench_writer_t;
+
+
+static struct {
+	file_fsInfo_t fsInfo;
+	bench_writer_t *writers;
+
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	int started;
+	volatile int stop;
+} common = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+};
+
+
+static uint64_t bench_nowNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+static int bench_cmp(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+
+/* Reservoir sampling of write latencies */
+static void bench_sample(bench_writer_t *w, uint32_t latency)
+{
+	uint32_t idx;
+
+	if (w->ops < BENCH_MAX_SAMPLES) {
+		w->latency[w->ops] = latency;
+		return;
+	}
+
+	w->seed ^= w->seed << 13;
+	w->seed ^= w->seed >> 17;
+	w->seed ^= w->seed << 5;
+
+	idx = w->seed % (w->ops + 1U);
+	if (idx < BENCH_MAX_SAMPLES) {
+		w->latency[idx] = latency;
+	}
+}
+
+
+static void *bench_writer(void *arg)
+{
+	bench_writer_t *w = arg;
+	unsigned char record[BENCH_RECORDSZ];
+	uint64_t start, latency;
+	int ret;
+
+	(void)memset(record, 0, sizeof(record));
+	record[0] = (unsigned char)w->idx;
+
+	(void)pthread_mutex_lock(&common.lock);
+	while (common.started == 0) {
+		(void)pthread_cond_wait(&common.cond, &common.lock);
+	}
+	(void)pthread_mutex_unlock(&common.lock);
+
+	/* no assertions here, Unity can't handle failures outside of the test thread */
+	while (common.stop == 0) {
+		(void)memcpy(record + 1, &w->ops, sizeof(w->ops));
+
+		start = bench_nowNs();
+		ret = file_write(w->fd, record, sizeof(record));
+		latency = bench_nowNs() - start;
+		if (ret != (int)sizeof(record)) {
+			w->err = (ret < 0) ? ret : -EIO;
+			break;
+		}
+
+		bench_sample(w, (latency > UINT32_MAX) ? UINT32_MAX : (uint32_t)latency);
+		w->ops++;
+	}
+
+	return NULL;
+}
+
+
+/* Releases writers still waiting for the start and joins them, used when not all of them could be created */
+static void bench_abort(unsigned int nwriters)
+{
+	unsigned int i;
+
+	(void)pthread_mutex_lock(&common.lock);
+	common.stop = 1;
+	common.started = 1;
+	(void)pthread_cond_broadcast(&common.cond);
+	(void)pthread_mutex_unlock(&common.lock);
+
+	for (i = 0; i < nwriters; ++i) {
+		(void)pthread_join(common.writers[i].tid, NULL);
+	}
+}
+
+
+/* Returns aggregate throughput in records/s */
+static double bench_run(unsigned int nwriters, int shared)
+{
+	uint64_t start, end;
+	unsigned long total = 0;
+	unsigned int i;
+	int ret;
+
+	common.started = 0;
+	common.stop = 0;
+
+	for (i = 0; i < nwriters; ++i) {
+		common.writers[i].idx = i;
+		common.writers[i].err = 0;
+		common.writers[i].ops = 0;
+		common.writers[i].seed = 2463534242U + i;
+		ret = pthread_create(&common.writers[i].tid, NULL, bench_writer, &common.writers[i]);
+		if (ret != 0) {
+			/* failed assertion doesn't return, writers created so far would be left waiting */
+			bench_abort(i);
+			TEST_ASSERT_EQUAL(0, ret);
+		}
+	}
+
+	(void)pthread_mutex_lock(&common.lock);
+	common.started = 1;
+	start = bench_nowNs();
+	(void)pthread_cond_broadcast(&common.cond);
+	(void)pthread_mutex_unlock(&common.lock);
+
+	(void)usleep(BENCH_DURATION_MS * 1000);
+	common.stop = 1;
+
+	for (i = 0; i < nwriters; ++i) {
+		TEST_ASSERT_EQUAL(0, pthread_join(common.writers[i].tid, NULL));
+	}
+	end = bench_nowNs();
+
+	for (i = 0; i < nwriters; ++i) {
+		TEST_ASSERT_EQUAL_MESSAGE(0, common.writers[i].err, shared ? "shared file write failed" : "file write failed");
+		total += common.writers[i].ops;
+	}
+
+	return total * 1e9 / (double)(end - start);
+}
+
+
+static void bench_report(const char *name, unsigned int nwriters, double rate)
+{
+	double sum = 0.0, sumSq = 0.0;
+	uint32_t p99, worstP99 = 0, max = 0;
+	unsigned long cnt;
+	unsigned int i;
+
+	for (i = 0; i < nwriters; ++i) {
+		bench_writer_t *w = &common.writers[i];
+
+		cnt = (w->ops < BENCH_MAX_SAMPLES) ? w->ops : BENCH_MAX_SAMPLES;
+		TEST_ASSERT_NOT_EQUAL(0, cnt);
+		qsort(w->latency, cnt, sizeof(w->latency[0]), bench_cmp);
+
+		p99 = w->latency[(cnt * 99U) / 100U];
+		(void)printf("METRIC name=%s.writer%u.p50 value=%u unit=ns better=lower\n", name, i, (unsigned int)w->latency[cnt / 2U]);
+		(void)printf("METRIC name=%s.writer%u.p99 value=%u unit=ns better=lower\n", name, i, (unsigned int)p99);
+
+		worstP99 = (p99 > worstP99) ? p99 : worstP99;
+		max = (w->latency[cnt - 1U] > max) ? w->latency[cnt - 1U] : max;
+		sum += w->ops;
+		sumSq += (double)w->ops * w->ops;
+	}
+
+	(void)printf("METRIC name=%s.bytes value=%.0f unit=B/s better=higher\n", name, rate * BENCH_RECORDSZ);
+	(void)printf("METRIC name=%s.worst_p99 value=%u unit=ns better=lower\n", name, (unsigned int)worstP99);
+	(void)printf("METRIC name=%s.max value=%u unit=ns better=lower\n", name, (unsigned int)max);
+	/* 1.0 if all writers wrote the same number of records, 1/N if a single one did all the work */
+	(void)printf("METRIC name=%s.fairness value=%.4f better=higher\n", name, (sum * sum) / (nwriters * sumSq));
+}
+
+
+static void bench_writers(unsigned int nwriters, int shared)
+{
+	char name[32], fileName[16];
+	double rate = 0.0;
+	unsigned int i;
+
+	(void)snprintf(name, sizeof(name), "%s.writers%u", shared ? "shared" : "own", nwriters);
+
+	/* writers log for longer than the files can hold, files turn during the measurement */
+	if (shared != 0) {
+		TEST_ASSERT_EQUAL(0, file_allocate("shared", 8, 4U * common.fsInfo.sectorsz, BENCH_RECORDSZ));
+	}
+	for (i = 0; i < nwriters; ++i) {
+		if (shared != 0) {
+			common.writers[i].fd = file_open("/shared");
+			TEST_ASSERT_GREATER_OR_EQUAL(0, common.writers[i].fd);
+		}
+		else {
+			(void)snprintf(fileName, sizeof(fileName), "own%u", i);
+			common.writers[i].fd = common_preallocOpenFile(fileName, 4, common.fsInfo.sectorsz, BENCH_RECORDSZ);
+		}
+	}
+
+	BENCHMARK(name, "rec/s", 1)
+	{
+		rate = bench_run(nwriters, shared);
+		UnityBenchmarkSample(rate);
+	}
+
+	bench_report(name, nwriters, rate);
+	file_flashReport(name);
+
+	for (i = 0; i < nwriters; ++i) {
+		TEST_ASSERT_EQUAL(0, file_close(common.writers[i].fd));
+	}
+	TEST_ASSERT_EQUAL(0, file_eraseAll());
+}
+
+
+TEST_GROUP(meterfs_concurrent);
+
+
+TEST_SETUP(meterfs_concurrent)
+{
+	TEST_ASSERT_EQUAL(0, file_devInfo(&common.fsInfo));
+
+	common.writers = calloc(BENCH_MAX_WRITERS, sizeof(common.writers[0]));
+	TEST_ASSERT_NOT_NULL(common.writers);
+}
+
+
+TEST_TEAR_DOWN(meterfs_concurrent)
+{
+	free(common.writers);
+	common.writers = NULL;
+
+	TEST_ASSERT_EQUAL(0, file_eraseAll());
+}
+
+
+/* Every writer logs to its own file, like independent processes of the meter */
+BENCH_TEST(meterfs_concurrent, own_files)
+{
+	unsigned int n;
+
+	for (n = 1; n <= BENCH_MAX_WRITERS; n *= 2U) {
+		bench_writers(n, 0);
+	}
+}
+
+
+/* All writers log to the same file */
+BENCH_TEST(meterfs_concurrent, shared_file)
+{
+	unsigned int n;
+
+	for (n = 1; n <= BENCH_MAX_WRITERS; n *= 2U) {
+		bench_writers(n, 1);
+	}
+}
+
+
+TEST_GROUP_RUNNER(meterfs_concurrent)
+{
+	RUN_TEST_CASE(meterfs_concurrent, own_files);
+	RUN_TEST_CASE(meterfs_concurrent, shared_file);
+}
+
+
+void runner(void)
+{
+	RUN_TEST_GROUP(meterfs_concurrent);
+}
+
+
+int main(int argc, char *argv[])
+{
+	/* mount path may be followed by Unity options, e.g. -b to run the benchmarks */
+	if (argc < 2) {
+		(void)printf("Usage: %s /meterfs/mount/path [unity options]\n", argv[0]);
+		return 1;
+	}
+	if (file_init(argv[1]) != 0) {
+		(void)printf("Failed to initialize test\n");
+		return 1;
+	}
+	if (file_eraseAll() != 0) {
+		(void)printf("Failed to format meterfs partition\n");
+		return 1;
+	}
+
+	return (UnityMain(argc, (const char **)argv, runner) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,253 @@
+/*
+ * Phoenix-RTOS
+ *
+ * Meterfs lookup and mount scaling benchmarks
+ *
+ * File lookup, open and mount times are measured against the number of files
+ * (up to the file limit of the filesystem) and against their fill level.
+ *
+ * Copyright 2025 Phoenix Systems
+ *
+ *
+ * %LICENSE%
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "common.h"
+
+
+#define BENCH_FILE_RECORDS 16 /* Capacity of every file in records */
+#define BENCH_NAME_LEN     12
+
+
+static const unsigned int fillLevels[] = { 0, 50, 100 }; /* in percent */
+
+
+static struct {
+	file_fsInfo_t fsInfo;
+	size_t maxFiles;
+	char (*names)[BENCH_NAME_LEN];
+	unsigned long long *latency;
+	unsigned char buffRec[256];
+} common;
+
+
+static unsigned long long bench_nowNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+static int bench_cmp(const void *a, const void *b)
+{
+	unsigned long long x = *(const unsigned long long *)a, y = *(const unsigned long long *)b;
+
+	return (x > y) - (x < y);
+}
+
+
+/* File counts to sweep, ends with the limit of the filesystem */
+static size_t bench_fileCounts(size_t *counts)
+{
+	static const size_t steps[] = { 1, 16, 64 };
+	size_t i, n = 0;
+
+	for (i = 0; i < sizeof(steps) / sizeof(steps[0]); ++i) {
+		if (steps[i] < common.maxFiles / 2U) {
+			counts[n++] = steps[i];
+		}
+	}
+	if ((common.maxFiles / 2U) != 0U) {
+		counts[n++] = common.maxFiles / 2U;
+	}
+	counts[n++] = common.maxFiles;
+
+	return n;
+}
+
+
+/* Creates files and fills each of them to the given percent of its capacity */
+static void bench_prepare(size_t files, unsigned int fill)
+{
+	size_t filesz = common.fsInfo.sectorsz / 4U, recordsz = filesz / BENCH_FILE_RECORDS, i, r;
+	int fd;
+
+	TEST_ASSERT_EQUAL(0, file_eraseAll());
+
+	for (i = 0; i < files; ++i) {
+		fd = common_preallocOpenFile(common.names[i] + 1, 2, filesz, recordsz);
+		for (r = 0; r < (BENCH_FILE_RECORDS * fill) / 100U; ++r) {
+			TEST_ASSERT_EQUAL_INT(recordsz, file_write(fd, common.buffRec, recordsz));
+		}
+		TEST_ASSERT_EQUAL(0, file_close(fd));
+	}
+}
+
+
+static void bench_lookup(size_t files, unsigned int fill)
+{
+	unsigned long long start, sum, missSum = 0, openSum = 0;
+	char name[64];
+	size_t i;
+	int fd;
+
+	(void)snprintf(name, sizeof(name), "lookup.files%zu.fill%u", files, fill);
+
+	BENCHMARK(name, "ns", 0)
+	{
+		sum = 0;
+		for (i = 0; i < files; ++i) {
+			start = bench_nowNs();
+			TEST_ASSERT_GREATER_OR_EQUAL(0, file_lookup(common.names[i]));
+			common.latency[i] = bench_nowNs() - start;
+			sum += common.latency[i];
+		}
+		UnityBenchmarkSample((double)sum / files);
+	}
+
+	qsort(common.latency, files, sizeof(common.latency[0]), bench_cmp);
+
+	for (i = 0; i < files; ++i) {
+		start = bench_nowNs();
+		TEST_ASSERT_EQUAL(-ENOENT, file_lookup("/nofile"));
+		missSum += bench_nowNs() - start;
+
+		start = bench_nowNs();
+		fd = file_open(common.names[i]);
+		TEST_ASSERT_GREATER_OR_EQUAL(0, fd);
+		TEST_ASSERT_EQUAL(0, file_close(fd));
+		openSum += bench_nowNs() - start;
+	}
+
+	(void)printf("METRIC name=%s.single_p99 value=%llu unit=ns better=lower\n", name, common.latency[(files * 99U) / 100U]);
+	(void)printf("METRIC name=%s.miss value=%.0f unit=ns better=lower\n", name, (double)missSum / files);
+	(void)printf("METRIC name=%s.open_close value=%.0f unit=ns better=lower\n", name, (double)openSum / files);
+}
+
+
+static void bench_mount(size_t files, unsigned int fill)
+{
+	unsigned long long ns = 0;
+	char name[64];
+
+	(void)snprintf(name, sizeof(name), "mount.files%zu.fill%u", files, fill);
+
+	BENCHMARK(name, "ns", 0)
+	{
+		TEST_ASSERT_EQUAL(0, file_mountTime(&ns));
+		UnityBenchmarkSample((double)ns);
+	}
+}
+
+
+TEST_GROUP(meterfs_scaling);
+
+
+TEST_SETUP(meterfs_scaling)
+{
+	size_t i;
+
+	TEST_ASSERT_EQUAL(0, file_devInfo(&common.fsInfo));
+
+	/* every file takes 2 sectors, one sector is reserved for the filesystem header */
+	common.maxFiles = ((common.fsInfo.sz / common.fsInfo.sectorsz) - 1U) / 2U;
+	if (common.maxFiles > common.fsInfo.fileLimit) {
+		common.maxFiles = common.fsInfo.fileLimit;
+	}
+
+	common.names = malloc(common.maxFiles * sizeof(common.names[0]));
+	common.latency = malloc(common.maxFiles * sizeof(common.latency[0]));
+	TEST_ASSERT_NOT_NULL(common.names);
+	TEST_ASSERT_NOT_NULL(common.latency);
+
+	for (i = 0; i < common.maxFiles; ++i) {
+		(void)snprintf(common.names[i], BENCH_NAME_LEN, "/f%u", (unsigned int)i);
+	}
+	(void)memset(common.buffRec, 0x5a, sizeof(common.buffRec));
+}
+
+
+TEST_TEAR_DOWN(meterfs_scaling)
+{
+	free(common.names);
+	free(common.latency);
+	common.names = NULL;
+	common.latency = NULL;
+
+	TEST_ASSERT_EQUAL(0, file_eraseAll());
+}
+
+
+/* Lookup latency of every file, lookup of a missing file and open + close */
+BENCH_TEST(meterfs_scaling, lookup)
+{
+	size_t counts[8], n, i, f;
+
+	n = bench_fileCounts(counts);
+	for (i = 0; i < n; ++i) {
+		for (f = 0; f < sizeof(fillLevels) / sizeof(fillLevels[0]); ++f) {
+			bench_prepare(counts[i], fillLevels[f]);
+			bench_lookup(counts[i], fillLevels[f]);
+		}
+	}
+}
+
+
+/* Time of mounting the filesystem, it dominates the startup time of the meter */
+BENCH_TEST(meterfs_scaling, mount)
+{
+	unsigned long long ns;
+	size_t counts[8], n, i, f;
+
+	if (file_mountTime(&ns) == -ENOSYS) {
+		TEST_IGNORE_MESSAGE("Mount time can't be measured on this platform");
+	}
+
+	n = bench_fileCounts(counts);
+	for (i = 0; i < n; ++i) {
+		for (f = 0; f < sizeof(fillLevels) / sizeof(fillLevels[0]); ++f) {
+			bench_prepare(counts[i], fillLevels[f]);
+			bench_mount(counts[i], fillLevels[f]);
+		}
+	}
+}
+
+
+TEST_GROUP_RUNNER(meterfs_scaling)
+{
+	RUN_TEST_CASE(meterfs_scaling, lookup);
+	RUN_TEST_CASE(meterfs_scaling, mount);
+}
+
+
+void runner(void)
+{
+	RUN_TEST_GROUP(meterfs_scaling);
+}
+
+
+int main(int argc, char *argv[])
+{
+	/* mount path may be followed by Unity options, e.g. -b to run the benchmarks */
+	if (argc < 2) {
+		(void)printf("Usage: %s /meterfs/mount/path [unity options]\n", argv[0]);
+		return 1;
+	}
+	if (file_init(argv[1]) != 0) {
+		(void)printf("Failed to initialize test\n");
+		return 1;
+	}
+	if (file_eraseAll() != 0) {
+		(void)printf("Failed to format meterfs partition\n");
+		return 1;
+	}
+
+	return (UnityMain(argc, (const char **)argv, runner) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
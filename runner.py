@@ -164,6 +164,28 @@ def parse_args(targets: Dict[str, Type[TargetBase]], hosts: Dict[str, Type[Host]
         help="Run only the tests that match the regex",
     )
 
+    parser.add_argument(
+        "-j",
+        "--jobs",
+        default=1,
+        type=int,
+        help=(
+            "Run tests on JOBS independent instances of the target in parallel. "
+            "Every instance boots from its own copy of the target images. "
+            "Supported only on emulated targets with rootfs. By default runs %(default)d instance"
+        ),
+    )
+
+    parser.add_argument(
+        "--snapshot-reboot",
+        default=False,
+        action="store_true",
+        help=(
+            "Reboot QEMU targets by restoring the VM snapshot taken at the first shell prompt instead of "
+            "restarting the emulator. Falls back to the restart when the emulator doesn't support snapshots."
+        ),
+    )
+
     parser.add_argument(
         "--nightly",
         default=False,
@@ -171,6 +193,38 @@ def parse_args(targets: Dict[str, Type[TargetBase]], hosts: Dict[str, Type[Host]
         help="Nightly tests will be run",
     )
 
+    parser.add_argument(
+        "--baseline",
+        default=None,
+        metavar="FILE",
+        help=(
+            "YAML file with reference benchmark results (a section per target). "
+            "Metrics reported by tests are compared against it and regressions are reported."
+        ),
+    )
+
+    parser.add_argument(
+        "--baseline-tolerance",
+        default=10.0,
+        type=float,
+        metavar="PERCENT",
+        help="Default allowed deviation of a metric from the baseline. Defaults to %(default)s%%",
+    )
+
+    parser.add_argument(
+        "--baseline-fail",
+        default=False,
+        action="store_true",
+        help="Fail tests with regressed metrics instead of only warning about them.",
+    )
+
+    parser.add_argument(
+        "--update-baseline",
+        default=False,
+        action="store_true",
+        help="Store metrics from this (trusted) run in the --baseline file instead of comparing with it.",
+    )
+
     def is_dir(dirpath):
         """Check whether the provided path is a directory (if exists)"""
         if os.path.exists(dirpath) and not os.path.isdir(dirpath):
@@ -223,6 +277,18 @@ def parse_args(targets: Dict[str, Type[TargetBase]], hosts: Dict[str, Type[Host]
     if not args.test:
         args.test = [resolve_project_path()]
 
+    if args.update_baseline and not args.baseline:
+        parser.error("--update-baseline requires --baseline")
+
+    if args.jobs < 1:
+        parser.error("--jobs must be a positive number")
+
+    if args.jobs > 1 and not targets[args.target].supports_parallel():
+        parser.error(f"--jobs is not supported on {args.target} target")
+
+    if args.jobs > 1 and args.stream:
+        parser.error("streaming the DUT output is not supported with --jobs")
+
     if args.output and "." in args.output:
         # remove extension for output stem if possibly exists
         args.output = args.output.rsplit(".", 1)[0]
@@ -291,6 +357,12 @@ def main():
         output=args.output,
         kwargs=args.kwargs,
         regex=args.regex,
+        jobs=args.jobs,
+        snapshot_reboot=args.snapshot_reboot,
+        baseline=args.baseline,
+        baseline_tolerance=args.baseline_tolerance,
+        baseline_fail=args.baseline_fail,
+        update_baseline=args.update_baseline,
     )
 
     host_cls = hosts[args.host]
@@ -0,0 +1,184 @@
+from __future__ import annotations
+
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Dict, List, Optional, Sequence, Union
+
+import yaml
+
+from trunner.text import bold, red, yellow
+from trunner.types import Metric, Status, TestResult
+
+
+class BaselineError(Exception):
+    pass
+
+
+@dataclass
+class Regression:
+    result: TestResult
+    metric: Metric
+    reference: float
+    tolerance: float
+
+    @property
+    def change(self) -> Optional[float]:
+        """relative change against the baseline in percent, None for the zero reference (e.g. failure counters)"""
+        if self.reference == 0:
+            return None
+
+        return (self.metric.value - self.reference) / self.reference * 100
+
+    def __str__(self) -> str:
+        change = self.change
+        if change is None:
+            delta = f"{self.metric.value - self.reference:+g} {self.metric.unit}".rstrip()
+        else:
+            delta = f"{change:+.1f}%"
+        reference = f"{self.reference:g} {self.metric.unit}".rstrip()
+
+        return (
+            f"{self.result.full_name}: {self.metric.name} {self.metric} "
+            f"vs baseline {reference} ({delta}, tolerance {self.tolerance:g}%)"
+        )
+
+
+class Baseline:
+    """Reference benchmark results used to detect performance regressions.
+
+    Baseline is stored as a YAML file with a section per target, in each section metrics
+    are grouped by the (sub)test full name:
+
+    ia32-generic-qemu:
+      phoenix-rtos-tests/coremark_pro/core.core:
+        throughput: 0.1915
+        # tolerance (in percent) may be overridden per metric
+        latency: {value: 5.221, tolerance: 20}
+
+    Attributes:
+        path: Path to the baseline file.
+        target: Name of the target which section is used.
+        tolerance: Default allowed deviation from the reference value (in percent).
+        fail: If set, regressions fail the test, otherwise they're only reported.
+    """
+
+    def __init__(self, path: Path, target: str, tolerance: float = 10, fail: bool = False):
+        self.path = path
+        self.target = target
+        self.tolerance = tolerance
+        self.fail = fail
+        self.data: Dict[str, Dict[str, Dict[str, Union[float, Dict]]]] = {}
+
+    def load(self):
+        if not self.path.exists():
+            self.data = {}
+            return
+
+        with open(self.path, "r", encoding="utf-8") as f:
+            data = yaml.safe_load(f) or {}
+
+        if not isinstance(data, dict):
+            raise BaselineError(f"{self.path}: baseline must be a dictionary with a section per target")
+
+        self._validate(data)
+        self.data = data
+
+    def _validate(self, data: Dict):
+        """Checks all sections, not only the one of the target - they're written back by update()"""
+
+        for target, section in data.items():
+            if section is None:
+                continue
+
+            if not isinstance(section, dict):
+                raise BaselineError(f"{self.path}: {target}: section must be a dictionary of tests")
+
+            for name, entries in section.items():
+                if not isinstance(entries, dict):
+                    raise BaselineError(f"{self.path}: {target}: {name}: entry must be a dictionary of metrics")
+
+                for metric, entry in entries.items():
+                    try:
+                        self._reference(entry)
+                    except (KeyError, TypeError, ValueError) as e:
+                        raise BaselineError(
+                            f"{self.path}: {target}: {name}: {metric}: expected a number or "
+                            f"{{value: number, tolerance: number}}, got {entry!r}"
+                        ) from e
+
+    def _reference(self, entry) -> tuple[float, float]:
+        if isinstance(entry, dict):
+            return float(entry["value"]), float(entry.get("tolerance", self.tolerance))
+
+        return float(entry), self.tolerance
+
+    def _is_regression(self, metric: Metric, reference: float, tolerance: float) -> bool:
+        if metric.higher_is_better:
+            return metric.value < reference * (1 - tolerance / 100)
+
+        return metric.value > reference * (1 + tolerance / 100)
+
+    def compare(self, results: Sequence[TestResult]) -> List[Regression]:
+        """Compares metrics of passed tests with the baseline, returns found regressions.
+
+        In `fail` mode regressed (sub)results and their parent results are marked as failed.
+        """
+        section = self.data.get(self.target) or {}
+        regressions = []
+
+        for res in results:
+            for sub in (res, *res.subresults):
+                if sub.status != Status.OK:
+                    continue
+
+                reference_metrics = section.get(sub.full_name, {})
+                for metric in sub.metrics.values():
+                    if metric.name not in reference_metrics:
+                        continue
+
+                    reference, tolerance = self._reference(reference_metrics[metric.name])
+                    if not self._is_regression(metric, reference, tolerance):
+                        continue
+
+                    regression = Regression(sub, metric, reference, tolerance)
+                    regressions.append(regression)
+
+                    if self.fail:
+                        sub.status = Status.FAIL
+                        sub.msg = "\n".join(filter(None, [sub.msg, f"Performance regression: {regression}"]))
+                        res.status = Status.FAIL
+
+        return regressions
+
+    def update(self, results: Sequence[TestResult]):
+        """Stores metrics of passed tests as the new baseline for the target.
+
+        Entries of tests that were not run are kept, as well as per-metric tolerance overrides.
+        """
+        section = self.data.setdefault(self.target, {}) or {}
+        self.data[self.target] = section
+
+        for res in results:
+            for sub in (res, *res.subresults):
+                if sub.status != Status.OK or not sub.metrics:
+                    continue
+
+                entries = section.setdefault(sub.full_name, {})
+                for metric in sub.metrics.values():
+                    old = entries.get(metric.name)
+                    if isinstance(old, dict):
+                        old["value"] = metric.value
+                    else:
+                        entries[metric.name] = metric.value
+
+        with open(self.path, "w", encoding="utf-8") as f:
+            yaml.safe_dump(self.data, f, sort_keys=True)
+
+    def report(self, regressions: Sequence[Regression]):
+        if not regressions:
+            return
+
+        color = red if self.fail else yellow
+        print(bold(color(f"PERFORMANCE REGRESSIONS against {self.path} ({len(regressions)}):")))
+        for regression in regressions:
+            print(color(str(regression)))
@@ -25,6 +25,12 @@ class TestContext:
         verbosity: Verbose level of the output of tests.
         stream_output: Stream DUT output to stdout during test execution.
         output: If not None - file name stem to store the test results ([stem].csv, [stem].xml).
+        jobs: Number of target instances to run the tests on in parallel (emulated targets only).
+        snapshot_reboot: Reboot emulated targets by restoring the VM snapshot taken at the first shell prompt.
+        baseline: If not None - path to the file with reference benchmark results to compare against.
+        baseline_tolerance: Default allowed deviation from the baseline (in percent).
+        baseline_fail: Fail tests with regressed metrics instead of only reporting them.
+        update_baseline: Store metrics from this run as the new baseline instead of comparing.
     """
 
     port: Optional[str]
@@ -41,3 +47,9 @@ class TestContext:
     target: Optional[TargetBase] = None
     host: Optional[Host] = None
     regex: Optional[str] = None
+    jobs: int = 1
+    snapshot_reboot: bool = False
+    baseline: Optional[str] = None
+    baseline_tolerance: float = 10
+    baseline_fail: bool = False
+    update_baseline: bool = False
@@ -1,3 +1,5 @@
+import os
+import selectors
 import time
 
 from abc import ABC, abstractmethod
@@ -26,11 +28,22 @@ def clear_pexpect_buffer(pexpect_obj):
     This function should be used when pexpect obj doesn't transmit new bytes."""
 
     try:
+        # drain data pending on the descriptor (it's still passed to the logs)
         while True:
-            pexpect_obj.expect(r".+", timeout=0)
+            pexpect_obj.read_nonblocking(size=pexpect_obj.maxread, timeout=0)
     except (pexpect.TIMEOUT, pexpect.EOF):
         pass
 
+    pexpect_obj.buffer = pexpect_obj.string_type()
+
+
+def wait_readable(fd: int, timeout: Optional[float]) -> bool:
+    """Blocks until there is data to read on fd (or EOF) or timeout expires. Returns True if fd is readable."""
+
+    with selectors.DefaultSelector() as selector:
+        selector.register(fd, selectors.EVENT_READ)
+        return bool(selector.select(timeout))
+
 
 class Dut(ABC):
     """
@@ -70,24 +83,31 @@ class Dut(ABC):
             self.pexpect_proc.logfile_send = self._logfiles[1]
             self.pexpect_proc.logfile = self._logfiles[2]
 
-    def read(self, size: int = 512, timeout: float = 0.1) -> str:
-        """read out RAW output from the DUT with configurable timeout"""
-        if not self.pexpect_proc:
+    def read(self, size: int = 512, timeout: float = 0.1, idle_timeout: Optional[float] = None) -> str:
+        """read out RAW output from the DUT with configurable timeout
+
+        Reading wakes up on data arrival. If `idle_timeout` is set, it returns as soon as
+        the DUT stops transmitting for `idle_timeout` seconds instead of waiting for the whole `timeout`.
+        """
+        if not self.pexpect_proc or self.pexpect_proc.closed:
             return ""
 
         ret = ""
         abs_timeout = time.time() + timeout
-        remaining_size = size
-        remaining_time = abs_timeout - time.time()
-
-        while remaining_time > 0 and remaining_size > 0:
-            try:
-                ret += self.pexpect_proc.read_nonblocking(size=remaining_size, timeout=remaining_time)
-                remaining_size = size - len(ret)
-            except pexpect.TIMEOUT:
-                pass
-            except EOF:
-                break
+        remaining_time = timeout
+
+        while remaining_time > 0 and len(ret) < size:
+            wait_time = remaining_time if idle_timeout is None else min(remaining_time, idle_timeout)
+            if not wait_readable(self.pexpect_proc.child_fd, wait_time):
+                if idle_timeout is not None:
+                    break
+            else:
+                try:
+                    ret += self.pexpect_proc.read_nonblocking(size=size - len(ret), timeout=0)
+                except pexpect.TIMEOUT:
+                    pass
+                except EOF:
+                    break
 
             remaining_time = abs_timeout - time.time()
 
@@ -168,24 +188,45 @@ class ProcessDut(Dut):
         self.args = args
         self.kwargs = kwargs
 
+    def _wait_process_end(self, abs_timeout: float):
+        pidfd = None
+        try:
+            # pidfd becomes readable when the process terminates
+            pidfd = os.pidfd_open(self.pexpect_proc.pid)
+        except (AttributeError, OSError):
+            pass
+
+        try:
+            while self.pexpect_proc.isalive():
+                remaining_time = abs_timeout - time.time()
+                if remaining_time <= 0:
+                    raise TimeoutError("Timed out waiting for process end")
+
+                if pidfd is not None:
+                    wait_readable(pidfd, remaining_time)
+                else:
+                    time.sleep(min(0.1, remaining_time))
+        finally:
+            if pidfd is not None:
+                os.close(pidfd)
+
     def wait(self, timeout=5):
         """Wait with timeout for process end. Read out all data in the mean time (push it to logs)"""
 
-        wait_start = time.time()
+        abs_timeout = time.time() + timeout
         while True:
-            if wait_start + timeout < time.time():
+            remaining_time = abs_timeout - time.time()
+            if remaining_time <= 0:
                 raise TimeoutError("Timed out waiting for EOF")
             try:
-                # read out all remaining output from the program
-                self.pexpect_proc.read_nonblocking(size=512)
+                # read out all remaining output from the program, wakes up on new data or EOF
+                self.pexpect_proc.read_nonblocking(size=512, timeout=remaining_time)
+            except pexpect.TIMEOUT:
+                pass
             except EOF:
                 break
 
-        while self.pexpect_proc.isalive():
-            time.sleep(0.1)
-
-            if wait_start + timeout < time.time():
-                raise TimeoutError("Timed out waiting for process end")
+        self._wait_process_end(abs_timeout)
 
         return self.pexpect_proc.exitstatus
 
@@ -1,61 +1,202 @@
-from typing import Optional
+import re
+import time
+from typing import Dict, List, Optional
+
+import pexpect
 
 from trunner.ctx import TestContext
 from trunner.dut import Dut
-from trunner.types import Status, TestResult
+from trunner.types import Metric, Status, TestResult
 
 
-def unity_harness(dut: Dut, ctx: TestContext, result: TestResult) -> Optional[TestResult]:
-    assert_re = r"ASSERTION [\S]+:\d+:(?P<status>FAIL|INFO|IGNORE)(: (?P<msg>.*?))?\r"
-    result_re = r"TEST\((?P<group>\w+), (?P<name>\w+)\) (?P<status>PASS|IGNORE)"
+class UnityParser:
+    """Incremental parser of the Unity fixture output.
+
+    Output is consumed line by line, every line is inspected once and only the last failure
+    assertion is remembered between lines, so parsing time is linear in the output length
+    regardless of how much non-Unity output the test prints.
+
+    Attributes:
+        result: Test result to which subresults are added as soon as they're parsed.
+        stats: Number of parsed test cases per Unity status.
+        summary: Numbers from the final Unity message (total, fail, ignore), None until parsed.
+        done: Set after the final OK/FAIL line has been parsed.
+        errors: Malformed lines which were recognized but couldn't be parsed (e.g. METRIC).
+    """
+
+    assert_re = re.compile(
+        r"ASSERTION (?P<path>[\S]+):(?P<line>\d+):(?P<status>FAIL|INFO|IGNORE)(: (?P<msg>.*))?"
+    )
+    # test duration is printed only with the -t option
+    result_re = re.compile(
+        r"TEST\((?P<group>\w+), (?P<name>\w+)\) (?P<status>PASS|IGNORE)( \((?P<duration>\d+) ns\))?"
+    )
     # Fail need to have its own regex due to greedy matching
-    result_fail_re = r"TEST\((?P<group>\w+), (?P<name>\w+)\) (?P<status>FAIL) at (?P<path>.*?):(?P<line>\d+)\r"
-    final_re = r"(?P<total>\d+) Tests (?P<fail>\d+) Failures (?P<ignore>\d+) Ignored \r+\n(?P<result>OK|FAIL)"
+    result_fail_re = re.compile(
+        r"TEST\((?P<group>\w+), (?P<name>\w+)\) (?P<status>FAIL) at (?P<path>.*):(?P<line>\d+)"
+        r"( \((?P<duration>\d+) ns\))?$"
+    )
+    summary_re = re.compile(r"(?P<total>\d+) Tests (?P<fail>\d+) Failures (?P<ignore>\d+) Ignored $")
+    # benchmark results printed from within the test body, see Metric.from_str
+    metric_re = re.compile(r"METRIC (?P<fields>.*)")
+    # compact output record (enabled by the -c option): "@" + payload length (2 hex digits) + payload
+    compact_re = re.compile(r"@(?P<len>[0-9a-f]{2})(?P<payload>.*)")
+    compact_result_re = re.compile(
+        r"(?P<status>[PFI])(?P<id>[0-9a-f]+),(?P<line>[0-9a-f]+),(?P<duration>[0-9a-f]+),(?P<name>\w+)"
+    )
+    compact_status = {"P": "PASS", "F": "FAIL", "I": "IGNORE"}
+
+    def __init__(self, result: TestResult):
+        self.result = result
+        self.stats = {"FAIL": 0, "IGNORE": 0, "PASS": 0}
+        self.summary: Optional[Dict[str, int]] = None
+        self.done = False
+        self.errors: List[str] = []
+        self._last_assertion: Dict[str, str] = {}
+        self._compact_group = ""
+        self._compact_unit = ""
+
+    def _add_subresult(self, parsed: Dict[str, str]):
+        if self._last_assertion.get("msg"):
+            parsed["msg"] = self._last_assertion["msg"]
+            self._last_assertion = {}
+
+        if parsed.get("duration"):
+            self._add_duration(int(parsed["duration"]), "ns")
+
+        status = Status.from_str(parsed["status"])
+        subname = f"{parsed['group']}.{parsed['name']}"
+        if parsed.get("path") and parsed.get("line"):
+            parsed["msg"] = f"[{parsed['path']}:{parsed['line']}] " + (parsed.get("msg") or "")
+        self.result.add_subresult(subname, status, parsed.get("msg") or "")
+
+        self.stats[parsed["status"]] += 1
+
+    def _add_duration(self, value: int, unit: str):
+        sub = self.result.current_subresult
+        sub.add_metric("duration", value, unit, higher_is_better=False)
+        if unit == "ns":
+            sub.set_run_time(value / 1e9)
+
+    def _feed_compact(self, payload: str) -> bool:
+        kind, data = payload[:1], payload[1:]
+
+        if kind == "C":
+            self._compact_unit = data
+            return True
+
+        if kind == "G":
+            self._compact_group = data
+            return True
+
+        match = self.compact_result_re.fullmatch(payload)
+        if not match:
+            return False
+
+        parsed = {
+            "group": self._compact_group,
+            "name": match["name"],
+            "status": self.compact_status[match["status"]],
+        }
+        if parsed["status"] == "FAIL":
+            # file of the failed assertion is known only from the preceding ASSERTION line
+            parsed["path"] = self._last_assertion.get("path")
+            parsed["line"] = str(int(match["line"], 16))
+
+        if parsed["status"] != "IGNORE":
+            self._add_duration(int(match["duration"], 16), self._compact_unit)
+        self._add_subresult(parsed)
+        return True
 
-    last_assertion = {}
-    stats = {"FAIL": 0, "IGNORE": 0, "PASS": 0}
-    results = []
+    def feed(self, line: str) -> bool:
+        """Parses a single line of the output (without line ending).
+
+        Returns True if the line carried Unity information (test result, assertion, metric or summary).
+        """
+        line = line.rstrip("\r")
+
+        # cheap substring checks first - most of the lines are the output of tests themselves
+        if "TEST(" in line:
+            match = self.result_fail_re.search(line) or self.result_re.search(line)
+            if match:
+                self._add_subresult(match.groupdict())
+                return True
+
+        if "ASSERTION " in line:
+            match = self.assert_re.search(line)
+            if match:
+                if match["status"] in ("FAIL", "IGNORE"):
+                    self._last_assertion = match.groupdict()
+                return True
+
+        if line.startswith("@"):
+            match = self.compact_re.fullmatch(line)
+            if match and int(match["len"], 16) == len(match["payload"]):
+                if self._feed_compact(match["payload"]):
+                    return True
+
+        if line.startswith("METRIC "):
+            try:
+                metric = Metric.from_str(self.metric_re.match(line)["fields"])
+            except ValueError as e:
+                self.errors.append(str(e))
+                return True
+
+            # metric printed outside of a test case belongs to the whole run
+            sub = self.result.current_subresult
+            (sub if sub is not None else self.result).metrics[metric.name] = metric
+            return True
+
+        if self.summary is None:
+            if " Tests " in line:
+                match = self.summary_re.search(line)
+                if match:
+                    self.summary = {k: int(v) for k, v in match.groupdict().items()}
+                    return True
+        elif line.strip() in ("OK", "FAIL"):
+            self.done = True
+            return True
+
+        return False
+
+    def check_summary(self):
+        assert self.summary is not None, "Final Unity message has not been parsed"
+
+        summary = self.summary
+        stats = self.stats
+        assert (
+            summary["total"] == sum(stats.values())
+            and summary["fail"] == stats["FAIL"]
+            and summary["ignore"] == stats["IGNORE"]
+        ), "".join(("There is a mismatch between the number of parsed tests and overall results!\n",
+                    "Parsed results from the final Unity message (total, failed, ignored): ",
+                    f"{summary['total']}, {summary['fail']}, {summary['ignore']}\n",
+                    "Found test summary lines (total, failed, ignored): ",
+                    f"{sum(stats.values())}, {stats['FAIL']}, {stats['IGNORE']}"))
+
+
+def unity_harness(dut: Dut, ctx: TestContext, result: TestResult) -> Optional[TestResult]:
+    parser = UnityParser(result)
     # some unity tests (e.g. mprotect) take 20 or even 30+ seconds on zynqmp-qemu
     timeout_val = 30 if ctx.target.name != "aarch64a53-zynqmp-qemu" else 60
     if ctx.nightly:
         timeout_val = 60
 
-    while True:
-        idx = dut.expect([assert_re, result_re, result_fail_re, final_re], timeout=timeout_val)
-        parsed = dut.match.groupdict()
-
-        if idx == 0:
-            if parsed["status"] in ["FAIL", "IGNORE"]:
-                last_assertion = parsed
-        elif idx in (1, 2):
-            if last_assertion.get("msg"):
-                parsed["msg"] = last_assertion["msg"]
-                last_assertion = {}
-
-            status = Status.from_str(parsed["status"])
-            subname = f"{parsed['group']}.{parsed['name']}"
-            if "path" in parsed and "line" in parsed:
-                parsed["msg"] = f"[{parsed['path']}:{parsed['line']}] " + parsed.get("msg", "")
-            result.add_subresult(subname, status, parsed.get("msg", ""))
-
-            stats[parsed["status"]] += 1
-            results.append(parsed)
-        elif idx == 3:
-            for k, v in parsed.items():
-                if k != "result":
-                    parsed[k] = int(v)
-
-            assert (
-                parsed["total"] == sum(stats.values())
-                and parsed["fail"] == stats["FAIL"]
-                and parsed["ignore"] == stats["IGNORE"]
-            ), "".join(("There is a mismatch between the number of parsed tests and overall results!\n",
-                        "Parsed results from the final Unity message (total, failed, ignored): ",
-                        f"{parsed['total']}, {parsed['fail']}, {parsed['ignore']}\n",
-                        "Found test summary lines (total, failed, ignored): ",
-                        f"{sum(stats.values())}, {stats['FAIL']}, {stats['IGNORE']}"))
-
-            break
-
-    status = Status.FAIL if stats["FAIL"] != 0 else Status.OK
+    # timeout applies to the time between Unity messages, not between any lines of the output
+    deadline = time.time() + timeout_val
+    while not parser.done:
+        remaining_time = deadline - time.time()
+        if remaining_time <= 0:
+            raise pexpect.TIMEOUT(f"No Unity message within {timeout_val} seconds")
+
+        dut.expect_exact("\n", timeout=remaining_time)
+        if parser.feed(dut.before):
+            deadline = time.time() + timeout_val
+
+    parser.check_summary()
+
+    if parser.errors:
+        return TestResult(status=Status.FAIL, msg="\n".join(parser.errors))
+
+    status = Status.FAIL if parser.stats["FAIL"] != 0 else Status.OK
     return TestResult(status=status)
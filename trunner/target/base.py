@@ -102,3 +102,16 @@ class TargetBase(ABC):
     @abstractmethod
     def build_test(self, test: TestOptions) -> Callable[[TestResult], TestResult]:
         """Returns the complete harness to run the test specified in `test` argument"""
+
+    @classmethod
+    def supports_parallel(cls) -> bool:
+        """Tells if make_worker() is implemented, i.e. tests can be run with --jobs"""
+        return False
+
+    def make_worker(self, workdir: Path) -> "TargetBase":
+        """Returns an independent instance of the target that can run tests in parallel with this one.
+
+        Args:
+            workdir: Scratch directory owned by the worker, removed after the test campaign.
+        """
+        raise NotImplementedError(f"{self.name} target does not support running tests in parallel")
@@ -1,7 +1,11 @@
-from abc import abstractmethod
+import copy
+import re
+import shutil
 from pathlib import Path
 from typing import Callable, Optional, Sequence, TextIO
 
+import pexpect
+
 from trunner.ctx import TestContext
 from trunner.dut import Dut, QemuDut
 from trunner.harness import (
@@ -26,22 +30,141 @@ class QemuDutRebooter:
         self.dut.open()
 
 
+class SnapshotError(Exception):
+    pass
+
+
+class QemuSnapshotRebooter(QemuDutRebooter):
+    """Rebooter that restores the VM snapshot taken at the first shell prompt instead of restarting the emulator.
+
+    The snapshot is managed through the QEMU monitor multiplexed with the serial console
+    (`-serial mon:stdio`, default for `-nographic`) and requires disk images supporting
+    snapshots (qcow2). If any of it is unavailable, rebooter falls back to restarting the emulator.
+
+    Attributes:
+        prompt: Shell prompt after which the snapshot is taken.
+        prompt_timeout: Timeout to wait for the prompt after the cold boot.
+    """
+
+    MONITOR_SWITCH = "\x01c"  # Ctrl-A c
+    MONITOR_PROMPT = "(qemu) "
+    SNAPSHOT_TAG = "trunner"
+    # savevm/loadvm duration depends mostly on the guest RAM size
+    SNAPSHOT_TIMEOUT = 60
+
+    def __init__(self, dut: QemuDut, prompt: str, prompt_timeout: int = -1):
+        super().__init__(dut)
+        self.prompt = prompt
+        self.prompt_timeout = prompt_timeout
+        self.snapshot_taken = False
+        self.snapshot_supported = True
+
+    def _monitor(self, cmd: str) -> str:
+        """Executes command in the QEMU monitor and returns its output"""
+
+        self.dut.send(self.MONITOR_SWITCH)
+        self.dut.expect_exact(self.MONITOR_PROMPT, timeout=5)
+
+        try:
+            self.dut.sendline(cmd)
+            self.dut.expect_exact(self.MONITOR_PROMPT, timeout=self.SNAPSHOT_TIMEOUT)
+            output = self.dut.before
+        finally:
+            # leave the monitor even if the command timed out, otherwise console input goes to the monitor
+            if self.dut.isalive():
+                self.dut.send(self.MONITOR_SWITCH)
+
+        # monitor reports errors as "Error: ..." or "Device ... does not support snapshots"
+        if re.search(r"error|not support", output, re.IGNORECASE):
+            raise SnapshotError(output.strip())
+
+        return output
+
+    def _take_snapshot(self):
+        self.dut.expect_exact(self.prompt, timeout=self.prompt_timeout)
+
+        try:
+            self._monitor(f"savevm {self.SNAPSHOT_TAG}")
+            self.snapshot_taken = True
+        except (pexpect.TIMEOUT, pexpect.EOF, SnapshotError) as e:
+            print(f"QEMU snapshot is not available, falling back to the emulator restart: {e}")
+            self.snapshot_supported = False
+
+            if not isinstance(e, SnapshotError):
+                # savevm might still be running or the emulator died, the VM state is unknown
+                super().__call__()
+                return
+
+        # prompt has been consumed here, force a new one for the following harnesses
+        self.dut.send("\n")
+
+    def __call__(self, flash=False, hard=False):
+        if self.snapshot_taken:
+            try:
+                self._monitor(f"loadvm {self.SNAPSHOT_TAG}")
+                self.dut.send("\n")
+                return
+            except (pexpect.TIMEOUT, pexpect.EOF, SnapshotError):
+                # emulator might have died or the snapshot got broken, take a new one after the cold boot
+                self.snapshot_taken = False
+
+        super().__call__(flash=flash, hard=hard)
+
+        if self.snapshot_supported:
+            self._take_snapshot()
+
+
 class QemuTarget(TargetBase):
     def __init__(self, script: str):
         super().__init__()
         self.script = script
         # TODO Make sure that script path exists
         self.dut = QemuDut(f"{self.project_dir}/scripts/{self.script}", encoding="utf-8")
-        self.rebooter = QemuDutRebooter(self.dut)
+        self.snapshot_reboot = False
+        self.rebooter = self._create_rebooter()
 
     @classmethod
-    @abstractmethod
-    def from_context(cls, _: TestContext):
-        pass
+    def from_context(cls, ctx: TestContext):
+        target = cls()
+
+        # snapshot is taken at the shell prompt, targets loading tests through plo need the full reboot
+        if ctx.snapshot_reboot and target.rootfs:
+            target.snapshot_reboot = True
+            target.rebooter = target._create_rebooter()
+
+        return target
+
+    def _create_rebooter(self) -> QemuDutRebooter:
+        if self.snapshot_reboot:
+            return QemuSnapshotRebooter(self.dut, self.shell_prompt, self.prompt_timeout)
+
+        return QemuDutRebooter(self.dut)
 
     def flash_dut(self, host_log: TextIO):
         pass
 
+    @classmethod
+    def supports_parallel(cls) -> bool:
+        # see make_worker(), only targets with rootfs are supported
+        return cls.rootfs
+
+    def make_worker(self, workdir: Path) -> "QemuTarget":
+        """Returns a copy of the target running the emulator on a scratch copy of the boot images.
+
+        Emulator scripts resolve images relative to their own location, so copying the scripts
+        directory next to the target boot directory gives every worker its own writable disk.
+        """
+        if not self.rootfs:
+            return super().make_worker(workdir)
+
+        shutil.copytree(f"{self.project_dir}/scripts", workdir / "scripts")
+        shutil.copytree(self.boot_dir(), workdir / "_boot" / self.name)
+
+        worker = copy.copy(self)
+        worker.dut = QemuDut(str(workdir / "scripts" / self.script), encoding="utf-8")
+        worker.rebooter = worker._create_rebooter()
+        return worker
+
     def build_test(self, test: TestOptions) -> Callable[[TestResult], TestResult]:
         builder = HarnessBuilder()
 
@@ -72,10 +195,6 @@ class IA32GenericQemuTarget(QemuTarget):
     def __init__(self):
         super().__init__("ia32-generic-qemu-test.sh")
 
-    @classmethod
-    def from_context(cls, _: TestContext):
-        return cls()
-
 
 class RISCV64GenericQemuTarget(QemuTarget):
     name = "riscv64-generic-qemu"
@@ -84,10 +203,6 @@ class RISCV64GenericQemuTarget(QemuTarget):
     def __init__(self):
         super().__init__("riscv64-generic-qemu.sh")
 
-    @classmethod
-    def from_context(cls, _: TestContext):
-        return cls()
-
 
 class SPARCV8LeonGenericQemuTarget(QemuTarget):
     name = "sparcv8leon-generic-qemu"
@@ -97,10 +212,6 @@ class SPARCV8LeonGenericQemuTarget(QemuTarget):
     def __init__(self):
         super().__init__("sparcv8leon-generic-qemu-test.sh")
 
-    @classmethod
-    def from_context(cls, _: TestContext):
-        return cls()
-
 
 class ARMv7A9Zynq7000QemuTarget(QemuTarget):
     name = "armv7a9-zynq7000-qemu"
@@ -113,10 +224,6 @@ class ARMv7A9Zynq7000QemuTarget(QemuTarget):
         # Iterate over harness chain to find a ShellHarness to increase prompt_timeout value.
         self.prompt_timeout = 60
 
-    @classmethod
-    def from_context(cls, _: TestContext):
-        return cls()
-
 
 class AARCH64A53ZynqmpQemuTarget(QemuTarget):
     name = "aarch64a53-zynqmp-qemu"
@@ -127,10 +234,6 @@ class AARCH64A53ZynqmpQemuTarget(QemuTarget):
         # System initialization may take 30+ seconds on this target due to emulation limitations
         self.prompt_timeout = 60
 
-    @classmethod
-    def from_context(cls, _: TestContext):
-        return cls()
-
 
 class ARMV7R5FSyspageLoader(PloRamSyspageLoader):
     """Loads app binaries and file blobs into syspage via GDB on armv7r5f-zynqmp-qemu."""
@@ -183,10 +286,6 @@ class ARMV7R5FZynqmpQemuTarget(QemuTarget):
     def __init__(self):
         super().__init__("armv7r5f-zynqmp-qemu-test.sh")
 
-    @classmethod
-    def from_context(cls, _: TestContext):
-        return cls()
-
     def build_test(self, test: TestOptions) -> Callable[[TestResult], TestResult]:
         builder = HarnessBuilder()
 
@@ -0,0 +1,96 @@
+#
+# Phoenix-RTOS test runner
+#
+# Tests for the disk benchmark harness
+#
+# Copyright 2025 Phoenix Systems
+#
+
+import importlib.util
+from pathlib import Path
+
+import pytest
+
+from trunner.dut import ProcessDut
+from trunner.types import Status, TestResult, TestStage
+
+# Pytest tries to collect some classes as tests, mark them as not testable
+TestResult.__test__ = False
+TestStage.__test__ = False
+
+HARNESS_PATH = Path(__file__).parents[3] / "disk" / "test_disk.py"
+
+PASSING_LOG = """\
+test_disk: starting
+test=disk size=66060288 direct=1
+test=seek avg_us=1208 seeks=24
+test=pattern pattern=0x55 status=ok
+test=perf block=4096 iops=40364 read_bps=212506113 write_bps=135300129
+test=done status=ok
+test_disk: finished
+"""
+
+FAILING_LOG = """\
+test_disk: starting
+test=disk size=66060288 direct=1
+test_disk: bad pattern at offs=4096. Expected 0x55, got 0
+test=pattern pattern=0x55 status=fail
+test=perf block=4096 iops=40364 read_bps=212506113 write_bps=135300129
+test=done status=ok
+test_disk: finished
+"""
+
+
+@pytest.fixture(scope="module")
+def disk_harness():
+    spec = importlib.util.spec_from_file_location("disk_harness", HARNESS_PATH)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module.harness
+
+
+def run_harness(harness, tmp_path, log):
+    path = tmp_path / "test_disk.log"
+    path.write_text(log)
+
+    # output goes through a pty, line endings become \r\n as on the target console
+    dut = ProcessDut("cat", [str(path)], encoding="ascii", timeout=3)
+    dut.open()
+    result = TestResult("disk")
+    result.set_stage(TestStage.RUN)
+
+    try:
+        status = harness(dut, None, result).status
+    finally:
+        dut.close()
+
+    return status, result
+
+
+def test_passing_log(disk_harness, tmp_path):
+    status, result = run_harness(disk_harness, tmp_path, PASSING_LOG)
+
+    assert status == Status.OK
+    subresults = [(sub.subname, sub.status) for sub in result.subresults]
+    assert subresults == [
+        ("seek", Status.OK),
+        ("pattern.0x55", Status.OK),
+        ("perf.block4096", Status.OK),
+        ("done", Status.OK),
+    ]
+    assert result.subresults[2].metrics["iops"].value == 40364
+
+
+def test_failing_pattern(disk_harness, tmp_path):
+    status, result = run_harness(disk_harness, tmp_path, FAILING_LOG)
+
+    assert status == Status.FAIL
+    assert result.subresults[0].subname == "pattern.0x55"
+    assert result.subresults[0].status == Status.FAIL
+    assert "bad pattern at offs=4096" in result.subresults[0].msg
+
+
+def test_failing_done(disk_harness, tmp_path):
+    status, _ = run_harness(disk_harness, tmp_path, PASSING_LOG.replace("done status=ok", "done status=fail"))
+
+    assert status == Status.FAIL
@@ -0,0 +1,188 @@
+#
+# Phoenix-RTOS test runner
+#
+# Tests for the Unity output parser
+#
+# Copyright 2025 Phoenix Systems
+#
+
+from types import SimpleNamespace
+
+import pytest
+
+from trunner.dut import ProcessDut
+from trunner.harness.unity import UnityParser, unity_harness
+from trunner.types import Status, TestResult, TestStage
+
+# Pytest tries to collect some classes as tests, mark them as not testable
+TestResult.__test__ = False
+TestStage.__test__ = False
+
+# Unity fixture output covering all message kinds recognized by the parser
+RECORDED_LOG = """\
+Unity test run 1 of 1\r
+TEST(unity_example, example_1) PASS\r
+some output of the test itself\r
+ASSERTION sample/test/test-unity.c:35:FAIL: Expected 1 Was 2\r
+TEST(unity_example, example_2) FAIL at sample/test/test-unity.c:35\r
+TEST(unity_example, example_3) IGNORE\r
+METRIC name=push_pop.fifo64 value=1250000 unit=ops/s better=higher\r
+TEST(unity_example, example_4) PASS\r
+\r
+-----------------------\r
+4 Tests 1 Failures 1 Ignored \r
+FAIL\r
+"""
+
+# The same run in the compact output mode (-c option)
+COMPACT_LOG = """\
+Unity test run 1 of 1\r
+@07Ccycles\r
+@0eGunity_example\r
+@12P1,0,5f4,example_1\r
+some output of the test itself\r
+ASSERTION sample/test/test-unity.c:35:FAIL: Expected 1 Was 2\r
+@14F2,23,112e,example_2\r
+@10I3,0,0,example_3\r
+METRIC name=push_pop.fifo64 value=1250000 unit=ops/s better=higher\r
+@12P4,0,71c,example_4\r
+@10P5,0,1,@0aP6,0,1,x\r
+\r
+-----------------------\r
+4 Tests 1 Failures 1 Ignored \r
+FAIL\r
+"""
+
+
+def parse(lines):
+    result = TestResult("unity")
+    result.set_stage(TestStage.RUN)
+    parser = UnityParser(result)
+
+    for line in lines:
+        parser.feed(line)
+        if parser.done:
+            break
+
+    return parser, result
+
+
+def synthetic_log(n_lines):
+    """Unity-like log with one test result per 4 lines of test output"""
+    lines = []
+    n_tests = 0
+    while len(lines) < n_lines:
+        lines.extend(f"test output line {i} of test {n_tests}\r" for i in range(4))
+        lines.append(f"TEST(group, test_{n_tests}) PASS\r")
+        n_tests += 1
+
+    lines.extend(["", "-----------------------", f"{n_tests} Tests 0 Failures 0 Ignored \r", "OK\r"])
+    return lines
+
+
+def test_recorded_log():
+    parser, result = parse(RECORDED_LOG.splitlines())
+
+    assert parser.done
+    parser.check_summary()
+
+    subresults = [(sub.subname, sub.status) for sub in result.subresults]
+    assert subresults == [
+        ("unity_example.example_1", Status.OK),
+        ("unity_example.example_2", Status.FAIL),
+        ("unity_example.example_3", Status.SKIP),
+        ("unity_example.example_4", Status.OK),
+    ]
+    assert result.subresults[1].msg == "[sample/test/test-unity.c:35] Expected 1 Was 2"
+    assert result.subresults[3].metrics["push_pop.fifo64"].value == 1250000
+
+
+def test_compact_log():
+    parser, result = parse(COMPACT_LOG.splitlines())
+
+    assert parser.done
+    parser.check_summary()
+
+    subresults = [(sub.subname, sub.status) for sub in result.subresults]
+    assert subresults == [
+        ("unity_example.example_1", Status.OK),
+        ("unity_example.example_2", Status.FAIL),
+        ("unity_example.example_3", Status.SKIP),
+        ("unity_example.example_4", Status.OK),
+    ]
+    assert result.subresults[1].msg == "[sample/test/test-unity.c:35] Expected 1 Was 2"
+    assert result.subresults[0].metrics["duration"].value == 0x5F4
+    assert result.subresults[0].metrics["duration"].unit == "cycles"
+    assert "duration" not in result.subresults[2].metrics
+    assert result.subresults[3].metrics.keys() == {"duration", "push_pop.fifo64"}
+
+
+def test_timing_log():
+    log = RECORDED_LOG.replace("example_1) PASS", "example_1) PASS (1500 ns)")
+    log = log.replace("test-unity.c:35\r", "test-unity.c:35 (2000000 ns)\r")
+    parser, result = parse(log.splitlines())
+
+    assert parser.done
+    parser.check_summary()
+
+    assert result.subresults[0].metrics["duration"].value == 1500
+    assert result.subresults[1].msg == "[sample/test/test-unity.c:35] Expected 1 Was 2"
+    assert result.subresults[1].metrics["duration"].value == 2000000
+    assert result.subresults[1].to_junit_testcase("target").time == 0.002
+    assert "duration" not in result.subresults[3].metrics
+
+
+def test_summary_mismatch():
+    parser, _ = parse(RECORDED_LOG.replace("4 Tests", "5 Tests").splitlines())
+
+    with pytest.raises(AssertionError):
+        parser.check_summary()
+
+
+def test_malformed_metric():
+    log = RECORDED_LOG.replace("value=1250000", "value=fast")
+    parser, result = parse(log.splitlines())
+
+    assert parser.done
+    parser.check_summary()
+
+    assert parser.errors == ["Malformed metric: name=push_pop.fifo64 value=fast unit=ops/s better=higher"]
+    assert not result.subresults[3].metrics
+    assert len(result.subresults) == 4
+
+
+def test_metric_outside_of_test():
+    result = TestResult("unity")
+    parser = UnityParser(result)
+
+    assert parser.feed("METRIC name=startup value=12 unit=ms better=lower\r")
+    assert result.metrics["startup"].value == 12
+    assert not parser.errors
+
+
+def test_harness_feeds_every_line_once(tmp_path, monkeypatch):
+    """Harness passes every line of the DUT output to the parser exactly once, so parsing is linear"""
+
+    lines = synthetic_log(10000)
+    path = tmp_path / "unity.log"
+    path.write_text("\n".join(line.rstrip("\r") for line in lines) + "\n")
+
+    fed = []
+    feed = UnityParser.feed
+    monkeypatch.setattr(UnityParser, "feed", lambda self, line: fed.append(line) or feed(self, line))
+
+    # output goes through a pty, line endings become \r\n as on the target console
+    dut = ProcessDut("cat", [str(path)], encoding="ascii", timeout=10)
+    dut.open()
+    ctx = SimpleNamespace(target=SimpleNamespace(name="host-generic-pc"), nightly=False)
+    result = TestResult("unity")
+    result.set_stage(TestStage.RUN)
+
+    try:
+        status = unity_harness(dut, ctx, result).status
+    finally:
+        dut.close()
+
+    assert status == Status.OK
+    assert len(result.subresults) == 2000
+    assert [line.rstrip("\r") for line in fed] == [line.rstrip("\r") for line in lines]
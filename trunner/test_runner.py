@@ -1,20 +1,32 @@
+import copy
+import dataclasses
 import os
 import shutil
 import sys
 import re
+import tempfile
+import traceback
 import junitparser
+import yaml
+from contextlib import ExitStack
 from io import StringIO
 from pathlib import Path
 from collections import Counter
-from typing import List, Sequence, TextIO, Optional
+from queue import Empty, Queue
+from threading import Lock, Thread
+from typing import List, Sequence, TextIO, Optional, TYPE_CHECKING
 
+from trunner.baseline import Baseline, BaselineError
 from trunner.config import ConfigParser
 from trunner.ctx import TestContext
 from trunner.dut import Dut
-from trunner.harness import HarnessError, FlashError
+from trunner.harness import HarnessError, FlashError, PyHarness
 from trunner.text import green, red, yellow, magenta
 from trunner.types import Status, TestOptions, TestResult, TestStage, is_github_actions, get_ci_url
 
+if TYPE_CHECKING:
+    from trunner.target import TargetBase
+
 
 def _add_tests_module_to_syspath(project_path: Path):
     # Add phoenix-rtos-tests to python path to make sure that module is visible for tests, whenever they are
@@ -198,10 +210,12 @@ class TestRunner:
 
         fname = self.ctx.output + ".csv"
 
+        metric_labels = sorted({label for res in results for label in res.metric_labels()})
+
         with open(fname, "w", encoding="utf-8") as out_csv:
-            out_csv.write(TestResult.get_csv_header() + "\n")
+            out_csv.write(TestResult.get_csv_header(metric_labels) + "\n")
             for res in results:
-                out_csv.write(res.to_csv() + "\n")
+                out_csv.write(res.to_csv(metric_labels) + "\n")
 
         print(f"Test results written to: {fname}")
 
@@ -241,6 +255,47 @@ class TestRunner:
 
         print(f"Test results written to: {fname}")
 
+    def _run_test(self, target: "TargetBase", test: TestOptions, ctx: TestContext) -> TestResult:
+        """Builds and runs a single test on the given target instance."""
+
+        result = TestResult(test.name)
+
+        if test.ignore:
+            result.skip()
+            return result
+
+        set_logfiles(target.dut, ctx)
+        harness = target.build_test(test)
+
+        if not test.should_reboot:  # WARN: build_test may change TestOptions
+            # if not rebooting - force new prompt to appear
+            target.dut.send("\n")
+
+        test_result = None
+        assert harness is not None
+
+        try:
+            test_result = harness(result)
+            assert test_result is not None, "harness needs to return TestResult"
+            result.overwrite(test_result)
+        except HarnessError as e:
+            result.fail(str(e))
+
+        return result
+
+    def _set_reboot_strategy(self, target: "TargetBase", test: TestOptions, last_test_failed: bool):
+        # By default we don't want to reboot the entire device to speed up the test execution)
+        # if not explicitly required by the test.
+        if last_test_failed:
+            test.should_reboot = True
+
+        if self.ctx.nightly:
+            test.should_reboot = True
+
+        # We have to enter the bootloader in order to load file blobs or applications.
+        if not target.rootfs and test.bootloader and (test.bootloader.apps or test.bootloader.files):
+            test.should_reboot = True
+
     def run_tests(self, tests: Sequence[TestOptions]) -> Sequence[TestResult]:
         """It builds and runs tests based on given test options.
 
@@ -251,51 +306,20 @@ class TestRunner:
             tests: Sequence of test options that describe how test looks like.
         """
 
+        if self.ctx.jobs > 1:
+            return self.run_tests_parallel(tests)
+
         results = []
         # Ensure first test will start with reboot
         last_test_failed = True
 
         for test in tests:
-            # By default we don't want to reboot the entire device to speed up the test execution)
-            # if not explicitly required by the test.
-            if last_test_failed:
-                test.should_reboot = True
-
-            if self.ctx.nightly:
-                test.should_reboot = True
-
-            # We have to enter the bootloader in order to load file blobs or applications.
-            if (
-                not self.ctx.target.rootfs
-                and test.bootloader
-                and (test.bootloader.apps or test.bootloader.files)
-            ):
-                test.should_reboot = True
+            self._set_reboot_strategy(self.target, test, last_test_failed)
 
-            result = TestResult(test.name)
             self._print_test_header_begin(test)
+            result = self._run_test(self.target, test, self.ctx)
 
-            if test.ignore:
-                result.skip()
-            else:
-                set_logfiles(self.target.dut, self.ctx)
-                harness = self.target.build_test(test)
-
-                if not test.should_reboot:  # WARN: build_test may change TestOptions
-                    # if not rebooting - force new prompt to appear
-                    self.target.dut.send("\n")
-
-                test_result = None
-                assert harness is not None
-
-                try:
-                    test_result = harness(result)
-                    assert test_result is not None, "harness needs to return TestResult"
-                    result.overwrite(test_result)
-                except HarnessError as e:
-                    result.fail(str(e))
-
-            self.target.dut.read(timeout=0.1)  # try to read (pass to logs) remaining test output
+            self.target.dut.read(timeout=0.1, idle_timeout=0.02)  # try to read (pass to logs) remaining test output
             self._print_test_header_end(test)
             print(result.to_str(self.ctx.verbosity), end="", flush=True)
 
@@ -310,6 +334,130 @@ class TestRunner:
 
         return results
 
+    def _bind_test(self, test: TestOptions, ctx: TestContext) -> TestOptions:
+        """Returns a copy of test options with the harness bound to the worker target."""
+
+        test = dataclasses.replace(test, shell=copy.deepcopy(test.shell))
+        if isinstance(test.harness, PyHarness):
+            test.harness = PyHarness(ctx.target.dut, ctx, test.harness.pyharness, test.harness.kwargs)
+
+        return test
+
+    def _run_worker(
+        self, target: "TargetBase", queue: Queue, results: List[Optional[TestResult]], errors: List[str], lock: Lock
+    ):
+        """Runs tests taken from the shared queue until it's empty.
+
+        Unexpected errors stop the worker and are appended to `errors`, tests left in the queue
+        are picked up by the other workers.
+        """
+
+        try:
+            ctx = dataclasses.replace(self.ctx, target=target)
+            # Ensure first test will start with reboot
+            last_test_failed = True
+
+            while True:
+                try:
+                    idx, test = queue.get_nowait()
+                except Empty:
+                    break
+
+                test = self._bind_test(test, ctx)
+                self._set_reboot_strategy(target, test, last_test_failed)
+
+                try:
+                    result = self._run_test(target, test, ctx)
+                except Exception:
+                    result = TestResult(test.name)
+                    result.fail_unknown_exception()
+
+                target.dut.read(timeout=0.1, idle_timeout=0.02)  # try to read (pass to logs) remaining test output
+
+                with lock:
+                    print(f"{test.name}: {result.to_str(self.ctx.verbosity)}", end="", flush=True)
+                    results[idx] = result
+
+                    if not result.is_skip():
+                        save_logfiles(target.dut, result.shortname, self.ctx.logdir)
+
+                if not result.is_skip():
+                    last_test_failed = result.is_fail()
+        except Exception:
+            with lock:
+                errors.append(traceback.format_exc())
+        finally:
+            target.dut.close()
+
+    def run_tests_parallel(self, tests: Sequence[TestOptions]) -> Sequence[TestResult]:
+        """Runs tests on `ctx.jobs` independent target instances.
+
+        Every worker takes the next pending test from the shared queue as soon as it finishes
+        the previous one, so the campaign is bounded by the slowest worker instead of the sum
+        of all tests. Results are returned in the order of `tests` regardless of completion order.
+        """
+
+        queue: Queue = Queue()
+        for item in enumerate(tests):
+            queue.put(item)
+
+        results: List[Optional[TestResult]] = [None] * len(tests)
+        errors: List[str] = []
+        lock = Lock()
+        jobs = min(self.ctx.jobs, len(tests))
+
+        with ExitStack() as stack:
+            threads = []
+            for job in range(jobs):
+                workdir = Path(stack.enter_context(tempfile.TemporaryDirectory(prefix=f"trunner-job{job}-")))
+                try:
+                    worker = self.target.make_worker(workdir)
+                except Exception:
+                    errors.append(traceback.format_exc())
+                    continue
+
+                threads.append(Thread(target=self._run_worker, args=(worker, queue, results, errors, lock)))
+
+            for thread in threads:
+                thread.start()
+
+            for thread in threads:
+                thread.join()
+
+        # tests not run because all workers died (or none could be created)
+        for idx, test in enumerate(tests):
+            if results[idx] is not None:
+                continue
+
+            result = TestResult(test.name)
+            result.fail(msg="\n".join(["Test not run, parallel workers failed:", *errors]), summary="Worker Error")
+            print(f"{test.name}: {result.to_str(self.ctx.verbosity)}", end="", flush=True)
+            results[idx] = result
+
+        return results
+
+    def _check_baseline(self, results: Sequence[TestResult]):
+        """Compares benchmark results with the baseline or stores them as the new one"""
+
+        baseline = Baseline(
+            Path(self.ctx.baseline),
+            self.target.name,
+            tolerance=self.ctx.baseline_tolerance,
+            fail=self.ctx.baseline_fail,
+        )
+
+        try:
+            baseline.load()
+        except (BaselineError, yaml.YAMLError) as e:
+            print(red(f"Failed to load baseline: {e}"))
+            return
+
+        if self.ctx.update_baseline:
+            baseline.update(results)
+            print(f"Baseline written to: {self.ctx.baseline}")
+        else:
+            baseline.report(baseline.compare(results))
+
     def run(self) -> bool:
         """Runs the entire test campaign based on yamls given in test_paths attribute.
 
@@ -338,6 +486,9 @@ class TestRunner:
             _add_tests_module_to_syspath(self.ctx.project_path)
             results.extend(self.run_tests(tests))
 
+        if self.ctx.baseline:
+            self._check_baseline(results)
+
         sums = Counter(res.status for res in results)
 
         print(
@@ -10,7 +10,7 @@ from datetime import datetime
 from enum import Enum, auto
 from functools import total_ordering
 from pathlib import Path
-from typing import Callable, Dict, List, Optional
+from typing import Callable, Dict, List, Optional, Sequence
 
 import junitparser
 from trunner.text import bold, escape_invalid_xml_characters, green, red, remove_ansi_sequences, yellow
@@ -114,6 +114,50 @@ class TestType(str, Enum):
     UNSUPPORTED = auto()
 
 
+@dataclass
+class Metric:
+    """Single value measured by the test (e.g. benchmark throughput).
+
+    Attributes:
+        name: Name of the measured quantity, unique within (sub)result.
+        value: Measured value.
+        unit: Unit of the value, empty for dimensionless numbers.
+        higher_is_better: Direction of improvement, used when comparing runs.
+    """
+
+    name: str
+    value: float
+    unit: str = ""
+    higher_is_better: bool = True
+
+    @classmethod
+    def from_str(cls, fields: str) -> Metric:
+        """Creates metric from `key=value` fields of the METRIC line printed by benchmarks, for example:
+
+        METRIC name=push_pop.fifo64 value=1250000 unit=ops/s better=higher
+
+        `unit` and `better` (higher/lower) keys are optional.
+        """
+        try:
+            data = dict(field.split("=", 1) for field in fields.split())
+            return cls(
+                name=data["name"],
+                value=float(data["value"]),
+                unit=data.get("unit", ""),
+                higher_is_better=data.get("better", "higher") != "lower",
+            )
+        except (KeyError, ValueError) as e:
+            raise ValueError(f"Malformed metric: {fields}") from e
+
+    @property
+    def label(self) -> str:
+        """name with unit used as CSV column / JUnit property name"""
+        return f"{self.name}[{self.unit}]" if self.unit else self.name
+
+    def __str__(self) -> str:
+        return f"{self.value:g} {self.unit}".rstrip()
+
+
 class TestResult:
     def __init__(self, name=None, msg: str = "", status: Optional[Status] = None):
         self.msg = msg
@@ -121,6 +165,7 @@ class TestResult:
         self._status = status
         self._name = name
         self.subname = ""
+        self.metrics: Dict[str, Metric] = {}
 
         # test execution tracking
         self._timing_stage: Optional[TestStage] = None
@@ -130,7 +175,7 @@ class TestResult:
         self.set_stage(TestStage.INIT)
 
         # subresults
-        self._curr_subresult: TestResult
+        self._curr_subresult: Optional[TestResult] = None
         self.subresults: List[TestResult] = []
 
     @property
@@ -187,10 +232,35 @@ class TestResult:
         else:
             return Status.OK
 
+    def add_metric(self, name: str, value: float, unit: str = "", higher_is_better: bool = True) -> Metric:
+        """Add (or replace) value measured by the test. Returns the metric object."""
+        metric = Metric(name, value, unit, higher_is_better)
+        self.metrics[name] = metric
+        return metric
+
+    @property
+    def current_subresult(self) -> Optional[TestResult]:
+        """Sub-result being collected, it's committed by the next add_subresult call, None before the RUN stage"""
+        return self._curr_subresult
+
+    def metric_labels(self) -> List[str]:
+        """Returns labels of all metrics in result and its subresults."""
+        labels = {m.label for res in (self, *self.subresults) for m in res.metrics.values()}
+        return sorted(labels)
+
+    def _junit_properties(self):
+        props = junitparser.Properties()
+        for metric in self.metrics.values():
+            props.add_property(junitparser.Property(metric.label, f"{metric.value:g}"))
+
+        return props
+
     def to_junit_testcase(self, target: str):
         out = junitparser.TestCase(f"{target}:{self.full_name}")
         out.classname = self.name
         out.time = round(self._timing_data.get(TestStage.RUN, 0), 3)
+        if self.metrics:
+            out.append(self._junit_properties())
         if self.status != Status.OK:
             # remove ANSI codes (not valid within XML)
             msg = remove_ansi_sequences(self.msg)
@@ -216,6 +286,9 @@ class TestResult:
         if not self.subresults:
             out.add_testcase(self.to_junit_testcase(target))
         else:
+            for metric in self.metrics.values():
+                out.add_property(metric.label, f"{metric.value:g}")
+
             for res in self.subresults:
                 out.add_testcase(res.to_junit_testcase(target))
 
@@ -225,6 +298,7 @@ class TestResult:
         """Overwrite current global result (status, msg) with other one. Don't touch subtests"""
         self.msg = other.msg
         self.status = other.status
+        self.metrics.update(other.metrics)
         self.set_stage(TestStage.DONE)
 
     def set_stage(self, stage: TestStage):
@@ -234,7 +308,8 @@ class TestResult:
 
         if self._timing_stage is not None:
             duration = time.time() - self._timing_stage_start
-            self._timing_data[self._timing_stage] = duration
+            # keep the time set explicitly by set_run_time
+            self._timing_data.setdefault(self._timing_stage, duration)
 
         self._timing_stage = stage
         self._timing_stage_start = time.time()
@@ -243,6 +318,10 @@ class TestResult:
             self._start_time = datetime.utcnow()
             self._init_subresult()
 
+    def set_run_time(self, seconds: float):
+        """Override time of the RUN stage with the value measured by the test itself (e.g. on the DUT)"""
+        self._timing_data[TestStage.RUN] = seconds
+
     def _init_subresult(self):
         self._curr_subresult = TestSubResult(self.name)
 
@@ -360,17 +439,22 @@ class TestResult:
         self.msg = "\n".join([bold("EXCEPTION:"), traceback.format_exc()])
 
     @staticmethod
-    def get_csv_header() -> str:
+    def get_csv_header(metric_labels: Sequence[str] = ()) -> str:
         data = ["name", "subname", "status"]
         data.extend([str(stage) for stage in TestStage.important()])
+        data.extend(metric_labels)
 
         return ",".join(data)
 
-    def to_csv(self) -> str:
+    def to_csv(self, metric_labels: Sequence[str] = ()) -> str:
+        """Returns result and subresults as CSV rows, `metric_labels` selects extra metric columns"""
         data = [self.name, self.subname, self.status.name]
         data.extend([f"{self._timing_data.get(stage, 0):.3f}" for stage in TestStage.important()])
 
-        return "\n".join([",".join(data), *[subres.to_csv() for subres in self.subresults]])
+        metrics = {m.label: m for m in self.metrics.values()}
+        data.extend([f"{metrics[label].value:g}" if label in metrics else "" for label in metric_labels])
+
+        return "\n".join([",".join(data), *[subres.to_csv(metric_labels) for subres in self.subresults]])
 
 
 class TestSubResult(TestResult):
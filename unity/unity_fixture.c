@@ -8,9 +8,146 @@
 #include "unity_fixture.h"
 #include "unity_internals.h"
 #include <string.h>
+#include <time.h>
 
 struct UNITY_FIXTURE_T UnityFixture;
 
+/* Clock used to measure tests duration reported with the -t option.
+ * Define UNITY_FIXTURE_TIME_NS() to use a different clock. */
+#ifndef UNITY_FIXTURE_TIME_NS
+#ifdef CLOCK_MONOTONIC_RAW
+#define UNITY_FIXTURE_CLOCK CLOCK_MONOTONIC_RAW
+#else
+#define UNITY_FIXTURE_CLOCK CLOCK_MONOTONIC
+#endif
+static UNITY_UINT UnityFixtureTimeNs(void)
+{
+    struct timespec ts;
+    clock_gettime(UNITY_FIXTURE_CLOCK, &ts);
+    return (UNITY_UINT)ts.tv_sec * 1000000000u + (UNITY_UINT)ts.tv_nsec;
+}
+#define UNITY_FIXTURE_TIME_NS() UnityFixtureTimeNs()
+#endif
+
+/* Counter used to measure tests duration reported in the compact output.
+ * Define UNITY_FIXTURE_CYCLES() and UNITY_FIXTURE_CYCLES_UNIT to use a different counter. */
+#ifndef UNITY_FIXTURE_CYCLES
+#if (defined(__i386__) || defined(__x86_64__)) && defined(UNITY_SUPPORT_64)
+static UNITY_UINT UnityFixtureCycles(void)
+{
+    unsigned int lo, hi;
+    __asm__ volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((UNITY_UINT)hi << 32) | lo;
+}
+#define UNITY_FIXTURE_CYCLES() UnityFixtureCycles()
+#define UNITY_FIXTURE_CYCLES_UNIT "cycles"
+#else
+#define UNITY_FIXTURE_CYCLES() UNITY_FIXTURE_TIME_NS()
+#define UNITY_FIXTURE_CYCLES_UNIT "ns"
+#endif
+#endif
+
+/* Maximal number of measured iterations of a benchmark */
+#ifndef UNITY_BENCHMARK_MAX_SAMPLES
+#define UNITY_BENCHMARK_MAX_SAMPLES 100
+#endif
+
+static struct
+{
+    const char* name;
+    const char* unit;
+    int higherIsBetter;
+    unsigned int iteration;
+    unsigned int iterations;
+    unsigned int count;
+    UNITY_DOUBLE median;
+    UNITY_DOUBLE samples[UNITY_BENCHMARK_MAX_SAMPLES];
+} UnityBenchmark;
+
+/* Compact output: every message is a single line record "@LLpayload", where LL is the payload
+ * length in hex. Records are printed instead of the human-readable test results:
+ *   C<unit>                            - unit of the test duration, once per test run
+ *   G<group>                           - group of the following test records
+ *   <P|F|I><id>,<line>,<duration>,<name> - test result (P - pass, F - fail, I - ignore),
+ *                                        id, line of the failed assertion and duration in hex
+ * Failed assertion details are printed as in the human-readable output. */
+#define UNITY_COMPACT_RECORD_MAX 128
+
+struct UnityCompactRecord
+{
+    char buf[UNITY_COMPACT_RECORD_MAX];
+    unsigned int len;
+};
+
+static void compactAppendChar(struct UnityCompactRecord* record, char c)
+{
+    if (record->len < sizeof(record->buf))
+        record->buf[record->len++] = c;
+}
+
+static void compactAppendString(struct UnityCompactRecord* record, const char* s)
+{
+    while (*s != '\0')
+        compactAppendChar(record, *s++);
+}
+
+static void compactAppendHex(struct UnityCompactRecord* record, UNITY_UINT value)
+{
+    char digits[2 * sizeof(UNITY_UINT)];
+    unsigned int n = 0;
+
+    do
+    {
+        digits[n++] = "0123456789abcdef"[value & 0xf];
+        value >>= 4;
+    } while (value != 0);
+
+    while (n > 0)
+        compactAppendChar(record, digits[--n]);
+}
+
+static void compactEmit(const struct UnityCompactRecord* record)
+{
+    unsigned int i;
+
+    UNITY_OUTPUT_CHAR('@');
+    UNITY_OUTPUT_CHAR("0123456789abcdef"[(record->len >> 4) & 0xf]);
+    UNITY_OUTPUT_CHAR("0123456789abcdef"[record->len & 0xf]);
+    for (i = 0; i < record->len; i++)
+        UNITY_OUTPUT_CHAR(record->buf[i]);
+    UNITY_PRINT_EOL();
+}
+
+static void compactRecord(char type, const char* text)
+{
+    struct UnityCompactRecord record = { { 0 }, 0 };
+
+    compactAppendChar(&record, type);
+    compactAppendString(&record, text);
+    compactEmit(&record);
+}
+
+static void compactTestRecord(char status, const char* group, const char* name, UNITY_UINT line)
+{
+    struct UnityCompactRecord record = { { 0 }, 0 };
+
+    if (UnityFixture.CurrentGroup == 0 || strcmp(UnityFixture.CurrentGroup, group) != 0)
+    {
+        UnityFixture.CurrentGroup = group;
+        compactRecord('G', group);
+    }
+
+    compactAppendChar(&record, status);
+    compactAppendHex(&record, (UNITY_UINT)Unity.NumberOfTests);
+    compactAppendChar(&record, ',');
+    compactAppendHex(&record, line);
+    compactAppendChar(&record, ',');
+    compactAppendHex(&record, UnityFixture.CurrentTestCycles);
+    compactAppendChar(&record, ',');
+    compactAppendString(&record, name);
+    compactEmit(&record);
+}
+
 /* If you decide to use the function pointer approach.
  * Build with -D UNITY_OUTPUT_CHAR=outputChar and include <stdio.h>
  * int (*outputChar)(int) = putchar; */
@@ -40,6 +177,11 @@ int UnityMain(int argc, const char* argv[], void (*runAllTests)(void))
     {
         UnityBegin(argv[0]);
         announceTestRun(r);
+        if (UnityFixture.Compact)
+        {
+            UnityFixture.CurrentGroup = 0;
+            compactRecord('C', UNITY_FIXTURE_CYCLES_UNIT);
+        }
         runAllTests();
         UnityEnd();
     }
@@ -83,6 +225,8 @@ void UnityTestRunner(unityfunction* setup,
         UnityPointer_Init();
 
         UNITY_EXEC_TIME_START();
+        UnityFixture.CurrentTestTimeNs = UNITY_FIXTURE_TIME_NS();
+        UnityFixture.CurrentTestCycles = UNITY_FIXTURE_CYCLES();
 
         if (TEST_PROTECT())
         {
@@ -93,11 +237,16 @@ void UnityTestRunner(unityfunction* setup,
         {
             teardown();
         }
+        UnityFixture.CurrentTestCycles = UNITY_FIXTURE_CYCLES() - UnityFixture.CurrentTestCycles;
+        UnityFixture.CurrentTestTimeNs = UNITY_FIXTURE_TIME_NS() - UnityFixture.CurrentTestTimeNs;
         if (TEST_PROTECT())
         {
             UnityPointer_UndoAllSets();
         }
-        UnityConcludeFixtureTest();
+        if (UnityFixture.Compact)
+            UnityConcludeCompactTest(group, name);
+        else
+            UnityConcludeFixtureTest();
     }
 }
 
@@ -107,7 +256,12 @@ void UnityIgnoreTest(const char* printableName, const char* group, const char* n
     {
         Unity.NumberOfTests++;
         Unity.TestIgnores++;
-        if (UnityFixture.Verbose)
+        if (UnityFixture.Compact)
+        {
+            UnityFixture.CurrentTestCycles = 0;
+            compactTestRecord('I', group, name, 0);
+        }
+        else if (UnityFixture.Verbose)
         {
             UnityPrint(printableName);
             UnityPrint(" ");
@@ -166,11 +320,29 @@ void UnityPointer_UndoAllSets(void)
     }
 }
 
+static unsigned int parseNumber(const char* str)
+{
+    unsigned int number = 0;
+
+    while (*str >= '0' && *str <= '9')
+    {
+        number *= 10;
+        number += (unsigned int)*str++ - '0';
+    }
+
+    return number;
+}
+
 int UnityGetCommandLineOptions(int argc, const char* argv[])
 {
     int i;
     UnityFixture.Verbose = 0;
     UnityFixture.Silent = 0;
+    UnityFixture.Compact = 0;
+    UnityFixture.Timing = 0;
+    UnityFixture.Benchmark = 0;
+    UnityFixture.BenchmarkWarmup = 1;
+    UnityFixture.BenchmarkIterations = 10;
     UnityFixture.GroupFilter = 0;
     UnityFixture.NameFilter = 0;
     UnityFixture.RepeatCount = 1;
@@ -201,6 +373,16 @@ int UnityGetCommandLineOptions(int argc, const char* argv[])
             UNITY_PRINT_EOL();
             UnityPrint("  -r NUMBER   Repeatedly run all tests NUMBER times");
             UNITY_PRINT_EOL();
+            UnityPrint("  -c          Compact output: machine-readable test result records");
+            UNITY_PRINT_EOL();
+            UnityPrint("  -t          Print duration of every test");
+            UNITY_PRINT_EOL();
+            UnityPrint("  -b          Run benchmark tests");
+            UNITY_PRINT_EOL();
+            UnityPrint("  -w NUMBER   Number of benchmark warmup iterations (default: 1)");
+            UNITY_PRINT_EOL();
+            UnityPrint("  -i NUMBER   Number of benchmark measured iterations (default: 10)");
+            UNITY_PRINT_EOL();
             UnityPrint("  -h, --help  Display this help message");
             UNITY_PRINT_EOL();
             UNITY_PRINT_EOL();
@@ -225,6 +407,37 @@ int UnityGetCommandLineOptions(int argc, const char* argv[])
             UnityFixture.Silent = 1;
             i++;
         }
+        else if (strcmp(argv[i], "-c") == 0)
+        {
+            UnityFixture.Compact = 1;
+            i++;
+        }
+        else if (strcmp(argv[i], "-t") == 0)
+        {
+            UnityFixture.Timing = 1;
+            i++;
+        }
+        else if (strcmp(argv[i], "-b") == 0)
+        {
+            UnityFixture.Benchmark = 1;
+            i++;
+        }
+        else if (strcmp(argv[i], "-w") == 0)
+        {
+            i++;
+            if (i >= argc)
+                return 1;
+            UnityFixture.BenchmarkWarmup = parseNumber(argv[i]);
+            i++;
+        }
+        else if (strcmp(argv[i], "-i") == 0)
+        {
+            i++;
+            if (i >= argc)
+                return 1;
+            UnityFixture.BenchmarkIterations = parseNumber(argv[i]);
+            i++;
+        }
         else if (strcmp(argv[i], "-g") == 0)
         {
             i++;
@@ -299,8 +512,152 @@ void UnityConcludeFixtureTest(void)
         Unity.TestFailures++;
     }
 
+    if (UnityFixture.Timing && !Unity.CurrentTestIgnored && (UnityFixture.Verbose || Unity.CurrentTestFailed))
+    {
+        UnityPrint(" (");
+        UnityPrintNumberUnsigned(UnityFixture.CurrentTestTimeNs);
+        UnityPrint(" ns)");
+    }
+
     UNITY_PRINT_EOL();
 
     Unity.CurrentTestFailed = 0;
     Unity.CurrentTestIgnored = 0;
 }
+
+void UnityConcludeCompactTest(const char* group, const char* name)
+{
+    if (Unity.CurrentTestIgnored)
+    {
+        Unity.TestIgnores++;
+        compactTestRecord('I', group, name, 0);
+    }
+    else if (!Unity.CurrentTestFailed)
+    {
+        compactTestRecord('P', group, name, 0);
+    }
+    else /* Unity.CurrentTestFailed */
+    {
+        Unity.TestFailures++;
+        compactTestRecord('F', group, name, (UNITY_UINT)Unity.CurrentAssertionLineNumber);
+    }
+
+    Unity.CurrentTestFailed = 0;
+    Unity.CurrentTestIgnored = 0;
+}
+
+/*------------------------------------------------- */
+/* Benchmarks */
+
+int UnityBenchmarkEnabled(void)
+{
+    return UnityFixture.Benchmark;
+}
+
+void UnityBenchmarkBegin(const char* name, const char* unit, int higherIsBetter)
+{
+    UnityBenchmark.name = name;
+    UnityBenchmark.unit = unit;
+    UnityBenchmark.higherIsBetter = higherIsBetter;
+    UnityBenchmark.iteration = 0;
+    UnityBenchmark.count = 0;
+    UnityBenchmark.median = 0.0;
+    UnityBenchmark.iterations = UnityFixture.BenchmarkIterations;
+    if (UnityBenchmark.iterations > UNITY_BENCHMARK_MAX_SAMPLES)
+        UnityBenchmark.iterations = UNITY_BENCHMARK_MAX_SAMPLES;
+    if (UnityBenchmark.iterations == 0)
+        UnityBenchmark.iterations = 1;
+}
+
+void UnityBenchmarkSample(UNITY_DOUBLE value)
+{
+    /* samples of warmup iterations are dropped */
+    if (UnityBenchmark.iteration > UnityFixture.BenchmarkWarmup && UnityBenchmark.count < UnityBenchmark.iterations)
+        UnityBenchmark.samples[UnityBenchmark.count++] = value;
+}
+
+static UNITY_DOUBLE benchmarkSqrt(UNITY_DOUBLE x)
+{
+    UNITY_DOUBLE root = x;
+    int i;
+
+    if (x <= 0.0)
+        return 0.0;
+
+    /* Newton's method, not to depend on libm */
+    for (i = 0; i < 100; i++)
+        root = (root + x / root) / 2.0;
+
+    return root;
+}
+
+static void benchmarkPrintMetric(const char* stat, UNITY_DOUBLE value, int higherIsBetter)
+{
+    UnityPrint("METRIC name=");
+    UnityPrint(UnityBenchmark.name);
+    UNITY_OUTPUT_CHAR('.');
+    UnityPrint(stat);
+    UnityPrint(" value=");
+    UnityPrintFloat(value);
+    if (UnityBenchmark.unit != 0 && UnityBenchmark.unit[0] != '\0')
+    {
+        UnityPrint(" unit=");
+        UnityPrint(UnityBenchmark.unit);
+    }
+    UnityPrint(higherIsBetter ? " better=higher" : " better=lower");
+    UNITY_PRINT_EOL();
+}
+
+static void benchmarkReport(void)
+{
+    UNITY_DOUBLE* samples = UnityBenchmark.samples;
+    unsigned int n = UnityBenchmark.count;
+    UNITY_DOUBLE median, mean = 0.0, variance = 0.0;
+    unsigned int i, j;
+
+    if (n == 0)
+        return;
+
+    /* insertion sort, number of samples is small */
+    for (i = 1; i < n; i++)
+    {
+        UNITY_DOUBLE value = samples[i];
+        for (j = i; j > 0 && samples[j - 1] > value; j--)
+            samples[j] = samples[j - 1];
+        samples[j] = value;
+    }
+
+    for (i = 0; i < n; i++)
+        mean += samples[i];
+    mean /= (UNITY_DOUBLE)n;
+
+    for (i = 0; i < n; i++)
+        variance += (samples[i] - mean) * (samples[i] - mean);
+    variance /= (UNITY_DOUBLE)n;
+
+    median = (n % 2 != 0) ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2.0;
+    UnityBenchmark.median = median;
+
+    benchmarkPrintMetric("min", samples[0], UnityBenchmark.higherIsBetter);
+    benchmarkPrintMetric("median", median, UnityBenchmark.higherIsBetter);
+    /* nearest-rank 99th percentile */
+    benchmarkPrintMetric("p99", samples[(99 * n + 99) / 100 - 1], UnityBenchmark.higherIsBetter);
+    benchmarkPrintMetric("stddev", benchmarkSqrt(variance), 0);
+}
+
+UNITY_DOUBLE UnityBenchmarkMedian(void)
+{
+    return UnityBenchmark.median;
+}
+
+int UnityBenchmarkNext(void)
+{
+    if (UnityBenchmark.iteration < UnityFixture.BenchmarkWarmup + UnityBenchmark.iterations)
+    {
+        UnityBenchmark.iteration++;
+        return 1;
+    }
+
+    benchmarkReport();
+    return 0;
+}
@@ -52,6 +52,24 @@ int UnityMain(int argc, const char* argv[], void (*runAllTests)(void));
     }\
     void TEST_##group##_##name##_(void)
 
+/* Benchmark test: run only with the -b option, reported as ignored otherwise */
+#define BENCH_TEST(group, name) \
+    void TEST_##group##_##name##_bench(void);\
+    TEST(group, name)\
+    {\
+        if (!UnityBenchmarkEnabled())\
+            TEST_IGNORE_MESSAGE("Benchmark, use -b to run");\
+        TEST_##group##_##name##_bench();\
+    }\
+    void TEST_##group##_##name##_bench(void)
+
+/* Runs the following statement for warmup and measured iterations (-w, -i options),
+ * each measured iteration reports its result with UnityBenchmarkSample().
+ * Statistics of the samples are printed as METRIC lines after the last iteration,
+ * the median stays available with UnityBenchmarkMedian() until the next benchmark begins. */
+#define BENCHMARK(name, unit, higherIsBetter) \
+    for (UnityBenchmarkBegin((name), (unit), (higherIsBetter)); UnityBenchmarkNext(); )
+
 /* Call this for each test, insider the group runner */
 #define RUN_TEST_CASE(group, name) \
     { void TEST_##group##_##name##_run(void);\
@@ -17,9 +17,17 @@ struct UNITY_FIXTURE_T
 {
     int Verbose;
     int Silent;
+    int Compact;
+    int Timing;
+    int Benchmark;
+    unsigned int BenchmarkWarmup;
+    unsigned int BenchmarkIterations;
     unsigned int RepeatCount;
     const char* NameFilter;
     const char* GroupFilter;
+    const char* CurrentGroup;
+    UNITY_UINT CurrentTestCycles;
+    UNITY_UINT CurrentTestTimeNs;
 };
 extern struct UNITY_FIXTURE_T UnityFixture;
 
@@ -35,6 +43,12 @@ void UnityTestRunner(unityfunction* setup,
 void UnityIgnoreTest(const char* printableName, const char* group, const char* name);
 int UnityGetCommandLineOptions(int argc, const char* argv[]);
 void UnityConcludeFixtureTest(void);
+void UnityConcludeCompactTest(const char* group, const char* name);
+int UnityBenchmarkEnabled(void);
+void UnityBenchmarkBegin(const char* name, const char* unit, int higherIsBetter);
+int UnityBenchmarkNext(void);
+void UnityBenchmarkSample(UNITY_DOUBLE value);
+UNITY_DOUBLE UnityBenchmarkMedian(void);
 
 void UnityPointer_Set(void** pointer, void* newValue, UNITY_LINE_TYPE line);
 void UnityPointer_UndoAllSets(void);